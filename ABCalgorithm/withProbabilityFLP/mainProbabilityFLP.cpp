@@ -1,12 +1,19 @@
 #include <ecf/ECF.h>
 #include "FunctionMinEvalOp.h"
+#include "BatchDriver.h"
+#include "IndividualAttribute.h"
+#include "TrialCounter.h"
+#include "AcceptanceWalk.h"
+#include "FitnessRanking.h"
+#include "AllocationCounter.h"
+#include "PhaseProfiler.h"
 /**
  * \brief Artificial Bee Colony algorithm (see e.g. http://www.scholarpedia.org/article/Artificial_bee_colony_algorithm)
  * 
  * ABC algorithm accepts only a single FloatingPoint genotype (vector of real values).
- * Additionally, it adds the following genotype for algorithm implementation:
- * 		- trial: floatingPoint genotype serving as a generation counter for each individual
- *		- probability: floatingPoint genotype for calculating the probability of getting chosen for each individual
+ * Additionally, it keeps the following per-individual values (not genotypes) for algorithm implementation:
+ * 		- trial: generation counter for each individual (a TrialCounter, which keeps track of the maximum trial)
+ *		- probability: the probability of getting chosen for each individual (an IndividualAttribute)
  */
 
 class MyAlg : public Algorithm
@@ -17,6 +24,11 @@ protected:
         SelRandomOpP selRandomOp;
         SelBestOpP selBestOp;
 		SelFitnessProportionalOpP selFitOp;
+		FitnessRanking ranking;		// food sources ranked by fitness
+		TrialCounter trial;							// generations without improvement of each food source
+		IndividualAttribute<double> probability;	// probability of each food source getting chosen by an onlooker
+		std::vector<double> weights;	// probabilities of the food sources, in deme order
+		AcceptanceWalk onlookerWalk;	// chooses food sources for the onlookers
         
         uint limit;
 		double ubound;
@@ -65,20 +77,12 @@ public:
 				throw ("");
 			}
 
-			FloatingPointP flpoint[3];
-			for(uint iGen = 1; iGen < 3; iGen++) {
+			// every food source of a new run starts with trial 0 (and is abandoned soon after limit trials)
+			trial.clear(limit + 2);
+			probability.clear();
 
-				flpoint[iGen] = (FloatingPointP) new FloatingPoint::FloatingPoint;
-				state->setGenotype(flpoint[iGen]);
-
-				flpoint[iGen]->setParameterValue(state, "dimension", (voidP) new uint(1));					
-
-				// initial value of trial parameter should be (as close as possible to) 0				
-				flpoint[iGen]->setParameterValue(state, "lbound", (voidP) new double(0));
-				flpoint[iGen]->setParameterValue(state, "ubound", (voidP) new double(0.01));
-				
-			}
-			ECF_LOG(state, 1, "ABC algorithm: added 2 FloatingPoint genotypes (trial, probability)");
+			// phase timings of a new run are totalled separately
+			PhaseProfiler::instance().beginRun();
  
             return true;
         }
@@ -121,11 +125,17 @@ public:
               employedBeesPhase(state, deme);
 			  onlookerBeesPhase(state, deme);	
 			  scoutBeesPhase(state, deme);
+
+			  // with -DECF_COUNT_ALLOCATIONS, log this generation's allocations
+			  AllocationCounter::log(state);
+			  // with -DECF_PROFILE_PHASES, report this generation's phase timings
+			  PhaseProfiler::instance().endGeneration();
               return true;
         }
 
 		 bool employedBeesPhase(StateP state, DemeP deme)
         {	
+			PROFILE_PHASE("employedBeesPhase");
 			for( uint i = 0; i < deme->getSize(); i++ ) { // for each food source
 				IndividualP food = deme->at(i);
 				createNewFoodSource(food, state, deme);
@@ -134,22 +144,21 @@ public:
         }
 
 		 bool onlookerBeesPhase(StateP state, DemeP deme){
+			PROFILE_PHASE("onlookerBeesPhase");
 			calculateProbabilities(state, deme);
-			int demeSize = deme->getSize();
-			int i = 0;
-			int n = 0;
-			while( n < demeSize){
-				int fact = i++ % demeSize;
-				IndividualP food = deme->at(fact);
-				FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (food->getGenotype(2));
-				double &probability = flp->realValue[0];
-				
-				if ( state->getRandomizer()->getRandomDouble() < probability){
-					n++;
-					createNewFoodSource(food, state, deme);
-				}
-				
-					
+			std::vector<double> &foodProbability = probability.of(deme);
+
+			// walk the deme round-robin and accept each food source with its probability until every onlooker is placed;
+			// the walk finds each accepted source with a single random number (see AcceptanceWalk.h), so a colony of
+			// sources with low probabilities doesn't cost many rejected draws, and the onlookers are distributed as by the loop
+			weights.resize(deme->getSize());
+			for( uint i = 0; i < deme->getSize(); i++ )
+				weights[i] = foodProbability[deme->at(i)->index];
+			onlookerWalk.build(weights);
+
+			for( uint n = 0; n < deme->getSize(); n++ ) { // for each onlooker
+				IndividualP food = deme->at(onlookerWalk.sample(state->getRandomizer()));
+				createNewFoodSource(food, state, deme);
 			}
 			 
 			//for( uint i = 0; i < deme->getSize(); i++ ) { // for each food source
@@ -161,29 +170,18 @@ public:
 		 }
 
 		 bool scoutBeesPhase(StateP state, DemeP deme){
-			IndividualP unimproved ;
-
-			double maxTrial = 0;
-			for( uint i = 0; i < deme->getSize(); i++ ) { // for each food source
-				IndividualP food = deme->at(i);
-				//get food source's trial variable
-				FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (food->getGenotype(1));
-				double &trial = flp->realValue[0];
-				
-				//remember the source if its trial exceeded limit 
-				if (trial > limit && trial >maxTrial){
-					unimproved = food;
-					maxTrial = trial;
-				}					
-			}
-
-			//if there is a  food source that exceeded the limit, replace it with a random one
-			if (unimproved != NULL){
-					FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (unimproved->getGenotype(1));
-					double &trial = flp->realValue[0];
-					trial = 0;
-					flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (unimproved->getGenotype(0));
+			PROFILE_PHASE("scoutBeesPhase");
+			TrialBuckets &foodTrial = trial.of(deme);
+
+			//the food source with the maximum trial is known without scanning the deme; if its trial exceeded the limit,
+			//replace it with a random one
+			if (foodTrial.getMax() > limit){
+					IndividualP unimproved = deme->at(foodTrial.argMax());
+					foodTrial.reset(unimproved->index);
+					FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (unimproved->getGenotype(0));
 					flp->initialize(state);
+					PROFILE_PHASE("evaluate");
+					AllocationCounter::Evaluation evaluation;
 					evaluate(unimproved);
 			}
 
@@ -198,15 +196,10 @@ public:
 				neighbour = selRandomOp->select(*deme);
 			}while(food->index == neighbour->index);
 
-			//potential new food source
-			IndividualP newFood = copy(food);
-
 			FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (food->getGenotype(0));
 			std::vector< double > &foodVars = flp->realValue;
 			flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (neighbour->getGenotype(0));
 			std::vector< double > &neighbourVars = flp->realValue;
-			flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (newFood->getGenotype(0));
-			std::vector< double > &newFoodVars = flp->realValue;
 
 
 			uint param = state->getRandomizer()->getRandomInteger((int)foodVars.size());
@@ -218,35 +211,42 @@ public:
 				value = lbound;
 
 			//produce a modification on the food source (discover a new food source)
-			newFoodVars[param] = value;
-			evaluate(newFood);
+			//the new food source differs in a single coordinate, so it is tried in place instead of on a copy of the food source
+			double oldValue = foodVars[param];
+			FitnessP oldFitness = food->fitness;
+			foodVars[param] = value;
+			{
+				PROFILE_PHASE("evaluate");
+				AllocationCounter::Evaluation evaluation;
+				evaluate(food);
+			}
 
-			flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (food->getGenotype(1));
-			double &foodTrial = flp->realValue[0];
+			TrialBuckets &foodTrial = trial.of(deme);
 
 //			d)	if the fitness value of the new food source is better than that of the original source,
-//					memorize the new source, forget the old one and set trial to 0
-//					otherwise keep the old one and increment trial
-			if(newFood->fitness->isBetterThan( food->fitness) )
+//					memorize the new source (already in place, with its fitness), forget the old one and set trial to 0
+//					otherwise restore the old one and increment trial
+			if(food->fitness->isBetterThan( oldFitness) )
 			{
-				foodVars[param] = value;
-				evaluate(food);
-				foodTrial = 0;
+				foodTrial.reset(food->index);
 			}
 			else {
-				foodTrial +=1;
+				foodVars[param] = oldValue;
+				food->fitness = oldFitness;
+				foodTrial.increment(food->index);
 			}
 			return true;
 		}
-		bool calculateProbabilities(StateP state, DemeP deme){
-			IndividualP bestFood =  selBestOp->select(*deme);
+		bool calculateProbabilities(StateP, DemeP deme){
+			ranking.load(*deme);
+			IndividualP bestFood =  deme->at(ranking.best());
 			double bestFitness = bestFood->fitness->getValue();
+			std::vector<double> &foodProbability = probability.of(deme);
 
 			for( uint i = 0; i < deme->getSize(); i++ ) { // for each food source
 				IndividualP food = deme->at(i);
 				double thisFitness = food->fitness->getValue();
-				FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (food->getGenotype(2));
-				double &probability = flp->realValue[0];
+				double &probability = foodProbability[food->index];
 				
 				if (bestFitness == thisFitness)
 					probability = 1.0;
@@ -286,68 +286,27 @@ typedef boost::shared_ptr<MyAlg> MyAlgP;
 
 
 //
-// this main() function iterates over multiple COCO functions and optimizes each one in turn
+// this main() function optimizes COCO functions 1-24, batch.repeats times each;
+// every (function, repeat) run is an independent job, spread over all cores (see BatchDriver.h)
 // function Ids: noiseless 1-24, noisy 101-130
 //
 
-int main(int argc, char **argv)
+// creates the State for a single (function, repeat) job
+StateP createState()
 {
-	// run for selected COCO functions
-	for(uint function = 1; function < 25; function++) {
-
-		// read XML config
-		std::ifstream fin(argv[1]);
-		if (!fin) {
-			throw std::string("Error opening file! ");
-		}
-
-		std::string xmlFile, temp;
-		while (!fin.eof()) {
-			getline(fin, temp);
-			xmlFile += "\n" + temp;
-		}
-		fin.close();
-
-		// set log and stats parameters
-		std::string funcName = uint2str(function);
-		std::string logName = "log", statsName = "stats";
-		if(function < 10) {
-			logName += "0";
-			statsName += "0";
-		}
-		logName += uint2str(function) + ".txt";
-		statsName += uint2str(function) + ".txt";
+	StateP state (new State);
 
-		// update in XML
-		XMLResults results;
-		XMLNode xConfig = XMLNode::parseString(xmlFile.c_str(), "ECF", &results);
-		XMLNode registry = xConfig.getChildNode("Registry");
+	//set newAlg
+	MyAlgP alg = (MyAlgP) new MyAlg;
+	state->addAlgorithm(alg);
+	// set the evaluation operator
+	state->setEvalOp(new FunctionMinEvalOp);
 
-		XMLNode func = registry.getChildNodeWithAttribute("Entry", "key", "coco.function");
-		func.updateText(funcName.c_str());
-		XMLNode log = registry.getChildNodeWithAttribute("Entry", "key", "log.filename");
-		log.updateText(logName.c_str());
-		XMLNode stats = registry.getChildNodeWithAttribute("Entry", "key", "batch.statsfile");
-		stats.updateText(statsName.c_str());
-
-		// write back
-		std::ofstream fout(argv[1]);
-		fout << xConfig.createXMLString(true);
-		fout.close();
-
-
-		// finally, run ECF on single function
-		StateP state (new State);
-
-		//set newAlg
-		MyAlgP alg = (MyAlgP) new MyAlg;
-		state->addAlgorithm(alg);
-		// set the evaluation operator
-		state->setEvalOp(new FunctionMinEvalOp);
-
-		state->initialize(argc, argv);
-		state->run();
-	}
+	return state;
+}
 
-	return 0;
+int main(int argc, char **argv)
+{
+	BatchDriver driver(argc, argv);
+	return driver.run(createState);
 }
@@ -1,11 +1,17 @@
 #include <ecf/ECF.h>
 #include "FunctionMinEvalOp.h"
+#include "BatchDriver.h"
+#include "TrialCounter.h"
+#include "FitnessRanking.h"
+#include "AliasTable.h"
+#include "AllocationCounter.h"
+#include "PhaseProfiler.h"
 /**
  * \brief Artificial Bee Colony algorithm (see e.g. http://www.scholarpedia.org/article/Artificial_bee_colony_algorithm)
  * 
  * ABC algorithm accepts only a single FloatingPoint genotype (vector of real values).
- * Additionally, it adds the following genotype for algorithm implementation:
- * 		- trial: floatingPoint genotype serving as a generation counter for each individual
+ * Additionally, it keeps the following per-individual value (not a genotype) for algorithm implementation:
+ * 		- trial: generation counter for each individual (a TrialCounter, which keeps track of the maximum trial)
  */
 class MyAlg : public Algorithm
 {
@@ -14,7 +20,11 @@ protected:
 
         SelRandomOpP selRandomOp;
         SelBestOpP selBestOp;
-		SelFitnessProportionalOpP selFitOp;
+		TrialCounter trial;					// generations without improvement of each food source
+		double selPressure;				// weight of the best food source relative to the worst one
+		FitnessRanking ranking;			// fitness keys of the food sources
+		std::vector<double> weights;	// selection weights of the food sources, in deme order
+		AliasTable onlookerTable;		// chooses food sources for the onlookers
         
         uint limit;
 		double ubound;
@@ -26,10 +36,9 @@ public:
 				name_ = "MyAlg";
 
 				// create selection operators needed
-				// in this case, selRandomOp, SelBestOp and selFitOp
+				// in this case, selRandomOp and SelBestOp (onlookers are chosen with an alias table, see calculateWeights)
                 selRandomOp = (SelRandomOpP) (new SelRandomOp);
                 selBestOp = (SelBestOpP) (new SelBestOp);
-				selFitOp = (SelFitnessProportionalOpP) (new SelFitnessProportionalOp);
         }
 
         //register any parameters
@@ -37,18 +46,25 @@ public:
         {	
 			// limit is a maximum number of cycles for each individual	
 			registerParameter(state, "limit", (voidP) new uint(100), ECF::INT);              
+			// fitness proportional selection pressure of the onlookers (default: SelFitnessProportionalOp's)
+			registerParameter(state, "selPressure", (voidP) new double(10), ECF::DOUBLE);
         }
 
         
         bool initialize(StateP state)
 		{		
 			// initialize all operators
-			selFitOp->initialize(state);
 			selBestOp->initialize(state);
 			selRandomOp->initialize(state);
 			
 			voidP limit_ = getParameterValue(state, "limit");
 			limit = *((uint*) limit_.get());
+			voidP selPressure_ = getParameterValue(state, "selPressure");
+			selPressure = *((double*) selPressure_.get());
+			if(selPressure < 1) {
+				ECF_LOG_ERROR(state, "Error: ABC selPressure must be at least 1!");
+				throw ("");
+			}
 
 			voidP lBound = state->getGenotypes()[0]->getParameterValue(state, "lbound");
 			lbound = *((double*) lBound.get());
@@ -62,20 +78,11 @@ public:
 				throw ("");
 			}
 
-			FloatingPointP flpoint[2];
-			for(uint iGen = 1; iGen < 2; iGen++) {
-
-				flpoint[iGen] = (FloatingPointP) new FloatingPoint::FloatingPoint;
-				state->setGenotype(flpoint[iGen]);
+			// every food source of a new run starts with trial 0 (and is abandoned soon after limit trials)
+			trial.clear(limit + 2);
 
-				flpoint[iGen]->setParameterValue(state, "dimension", (voidP) new uint(1));					
-
-				// initial value of trial parameter should be (as close as possible to) 0				
-				flpoint[iGen]->setParameterValue(state, "lbound", (voidP) new double(0));
-				flpoint[iGen]->setParameterValue(state, "ubound", (voidP) new double(0.01));
-				
-			}
-			ECF_LOG(state, 1, "ABC algorithm: added 1 FloatingPoint genotype (trial)");
+			// phase timings of a new run are totalled separately
+			PhaseProfiler::instance().beginRun();
  
             return true;
         }
@@ -118,11 +125,17 @@ public:
               employedBeesPhase(state, deme);
 			  onlookerBeesPhase(state, deme);	
 			  scoutBeesPhase(state, deme);
+
+			  // with -DECF_COUNT_ALLOCATIONS, log this generation's allocations
+			  AllocationCounter::log(state);
+			  // with -DECF_PROFILE_PHASES, report this generation's phase timings
+			  PhaseProfiler::instance().endGeneration();
               return true;
         }
 
 		 bool employedBeesPhase(StateP state, DemeP deme)
         {	
+			PROFILE_PHASE("employedBeesPhase");
 			for( uint i = 0; i < deme->getSize(); i++ ) { // for each food source
 				IndividualP food = deme->at(i);
 				createNewFoodSource(food, state, deme);
@@ -131,39 +144,53 @@ public:
         }
 
 		 bool onlookerBeesPhase(StateP state, DemeP deme){
+			PROFILE_PHASE("onlookerBeesPhase");
+			calculateWeights(state, deme);
+			onlookerTable.build(weights);
 
 			for( uint i = 0; i < deme->getSize(); i++ ) { // for each food source
 				//choose a food source depending on it's fitness value ( better individuals are more likely to be chosen)
-				IndividualP food = selFitOp->select(*deme);
+				IndividualP food = deme->at(onlookerTable.sample(state->getRandomizer()));
 				createNewFoodSource(food, state, deme);
 			}
 			return true;
 		 }
 
-		 bool scoutBeesPhase(StateP state, DemeP deme){
-			IndividualP unimproved ;
+		 // weights of fitness proportional selection, as in SelFitnessProportionalOp: linearly scaled
+		 // from 1 (worst food source) to selPressure (best food source), all equal if all fitness values are.
+		 // They are computed once per onlooker phase, from the fitness values at its start; SelFitnessProportionalOp
+		 // recomputed them for every onlooker, so a source improved by an onlooker weighed more for the next ones
+		 bool calculateWeights(StateP, DemeP deme){
+			ranking.load(*deme);
+			double bestKey = ranking.key(0), worstKey = ranking.key(0);
+			for( uint i = 1; i < ranking.size(); i++ ) {
+				bestKey = std::min(bestKey, ranking.key(i));
+				worstKey = std::max(worstKey, ranking.key(i));
+			}
 
-			double maxTrial = 0;
-			for( uint i = 0; i < deme->getSize(); i++ ) { // for each food source
-				IndividualP food = deme->at(i);
-				//get food source's trial variable
-				FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (food->getGenotype(1));
-				double &trial = flp->realValue[0];
-				
-				//remember the source if its trial exceeded limit 
-				if (trial > limit && trial >maxTrial){
-					unimproved = food;
-					maxTrial = trial;
-				}					
+			weights.resize(deme->getSize());
+			for( uint i = 0; i < deme->getSize(); i++ ) {
+				if (bestKey == worstKey)
+					weights[i] = 1;
+				else
+					weights[i] = 1 + (selPressure - 1) * (ranking.key(i) - worstKey) / (bestKey - worstKey);
 			}
+			return true;
+		 }
 
-			//if there is a  food source that exceeded the limit, replace it with a random one
-			if (unimproved != NULL){
-					FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (unimproved->getGenotype(1));
-					double &trial = flp->realValue[0];
-					trial = 0;
-					flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (unimproved->getGenotype(0));
+		 bool scoutBeesPhase(StateP state, DemeP deme){
+			PROFILE_PHASE("scoutBeesPhase");
+			TrialBuckets &foodTrial = trial.of(deme);
+
+			//the food source with the maximum trial is known without scanning the deme; if its trial exceeded the limit,
+			//replace it with a random one
+			if (foodTrial.getMax() > limit){
+					IndividualP unimproved = deme->at(foodTrial.argMax());
+					foodTrial.reset(unimproved->index);
+					FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (unimproved->getGenotype(0));
 					flp->initialize(state);
+					PROFILE_PHASE("evaluate");
+					AllocationCounter::Evaluation evaluation;
 					evaluate(unimproved);
 			}
 
@@ -178,15 +205,10 @@ public:
 				neighbour = selRandomOp->select(*deme);
 			}while(food->index == neighbour->index);
 
-			//potential new food source
-			IndividualP newFood = copy(food);
-
 			FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (food->getGenotype(0));
 			std::vector< double > &foodVars = flp->realValue;
 			flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (neighbour->getGenotype(0));
 			std::vector< double > &neighbourVars = flp->realValue;
-			flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (newFood->getGenotype(0));
-			std::vector< double > &newFoodVars = flp->realValue;
 
 
 			uint param = state->getRandomizer()->getRandomInteger((int)foodVars.size());
@@ -198,23 +220,29 @@ public:
 				value = lbound;
 
 			//produce a modification on the food source (discover a new food source)
-			newFoodVars[param] = value;
-			evaluate(newFood);
+			//the new food source differs in a single coordinate, so it is tried in place instead of on a copy of the food source
+			double oldValue = foodVars[param];
+			FitnessP oldFitness = food->fitness;
+			foodVars[param] = value;
+			{
+				PROFILE_PHASE("evaluate");
+				AllocationCounter::Evaluation evaluation;
+				evaluate(food);
+			}
 
-			flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (food->getGenotype(1));
-			double &foodTrial = flp->realValue[0];
+			TrialBuckets &foodTrial = trial.of(deme);
 
 //			d)	if the fitness value of the new food source is better than that of the original source,
-//					memorize the new source, forget the old one and set trial to 0
-//					otherwise keep the old one and increment trial
-			if(newFood->fitness->isBetterThan( food->fitness) )
+//					memorize the new source (already in place, with its fitness), forget the old one and set trial to 0
+//					otherwise restore the old one and increment trial
+			if(food->fitness->isBetterThan( oldFitness) )
 			{
-				foodVars[param] = value;
-				evaluate(food);
-				foodTrial = 0;
+				foodTrial.reset(food->index);
 			}
 			else {
-				foodTrial +=1;
+				foodVars[param] = oldValue;
+				food->fitness = oldFitness;
+				foodTrial.increment(food->index);
 			}
 			return true;
 		}
@@ -246,68 +274,27 @@ typedef boost::shared_ptr<MyAlg> MyAlgP;
 
 
 //
-// this main() function iterates over multiple COCO functions and optimizes each one in turn
+// this main() function optimizes COCO functions 1-24, batch.repeats times each;
+// every (function, repeat) run is an independent job, spread over all cores (see BatchDriver.h)
 // function Ids: noiseless 1-24, noisy 101-130
 //
 
-int main(int argc, char **argv)
+// creates the State for a single (function, repeat) job
+StateP createState()
 {
-	// run for selected COCO functions
-	for(uint function = 1; function < 25; function++) {
-
-		// read XML config
-		std::ifstream fin(argv[1]);
-		if (!fin) {
-			throw std::string("Error opening file! ");
-		}
-
-		std::string xmlFile, temp;
-		while (!fin.eof()) {
-			getline(fin, temp);
-			xmlFile += "\n" + temp;
-		}
-		fin.close();
-
-		// set log and stats parameters
-		std::string funcName = uint2str(function);
-		std::string logName = "log", statsName = "stats";
-		if(function < 10) {
-			logName += "0";
-			statsName += "0";
-		}
-		logName += uint2str(function) + ".txt";
-		statsName += uint2str(function) + ".txt";
+	StateP state (new State);
 
-		// update in XML
-		XMLResults results;
-		XMLNode xConfig = XMLNode::parseString(xmlFile.c_str(), "ECF", &results);
-		XMLNode registry = xConfig.getChildNode("Registry");
+	//set newAlg
+	MyAlgP alg = (MyAlgP) new MyAlg;
+	state->addAlgorithm(alg);
+	// set the evaluation operator
+	state->setEvalOp(new FunctionMinEvalOp);
 
-		XMLNode func = registry.getChildNodeWithAttribute("Entry", "key", "coco.function");
-		func.updateText(funcName.c_str());
-		XMLNode log = registry.getChildNodeWithAttribute("Entry", "key", "log.filename");
-		log.updateText(logName.c_str());
-		XMLNode stats = registry.getChildNodeWithAttribute("Entry", "key", "batch.statsfile");
-		stats.updateText(statsName.c_str());
-
-		// write back
-		std::ofstream fout(argv[1]);
-		fout << xConfig.createXMLString(true);
-		fout.close();
-
-
-		// finally, run ECF on single function
-		StateP state (new State);
-
-		//set newAlg
-		MyAlgP alg = (MyAlgP) new MyAlg;
-		state->addAlgorithm(alg);
-		// set the evaluation operator
-		state->setEvalOp(new FunctionMinEvalOp);
-
-		state->initialize(argc, argv);
-		state->run();
-	}
+	return state;
+}
 
-	return 0;
+int main(int argc, char **argv)
+{
+	BatchDriver driver(argc, argv);
+	return driver.run(createState);
 }
@@ -1,5 +1,13 @@
 #include <ecf/ECF.h>
 #include "FunctionMinEvalOp.h"
+#include "BatchDriver.h"
+#include "BatchEvaluator.h"
+#include "CloneArena.h"
+#include "CloneHeap.h"
+#include "HypermutationKernel.h"
+#include "AllocationCounter.h"
+#include "PhaseProfiler.h"
+#include "RunCounters.h"
 /**
  * \brief Clonal Selection Algorithm (see e.g. http://en.wikipedia.org/wiki/Clonal_Selection_Algorithm)
  * 
@@ -12,8 +20,36 @@
  *          - birthPhase: where d * populationSize of new antibodies are randomly created and added to the population for diversification
  *							
  * CLONALG algorithm accepts only a single FloatingPoint genotype
- * Additionally, if chosen, selectionScheme CLONALG1 adds a FloatingPoint genotype  (parentAntibody) to mark which clone came from which antibods 
+ * The clone population is kept in a CloneArena; antibodies are written back to the deme only in replacePopulation
+ * Each clone row records its parent antibody, so selectionScheme CLONALG1 needs no additional genotype
+ * cloningVersion and selectionScheme are policies (below): initialize() picks the generation instantiated for them
  */
+
+// cloning policies: number of clones of the antibody of rank i (0 for the best)
+struct StaticCloning
+{
+		static uint cloneNo(uint clonesPerAntibody, uint)
+		{	return clonesPerAntibody;	}
+};
+
+struct ProportionalCloning
+{
+		static uint cloneNo(uint clonesPerAntibody, uint i)
+		{	return clonesPerAntibody/(i+1);	}
+};
+
+// selection policies: CLONALG1 first keeps the best clone of every antibody, CLONALG2 selects from all clones
+struct Clonalg1Selection
+{
+		enum { BEST_OF_PARENT = 1 };
+};
+
+struct Clonalg2Selection
+{
+		enum { BEST_OF_PARENT = 0 };
+};
+
+
 class MyAlg : public Algorithm
 {
 protected:
@@ -28,23 +64,25 @@ protected:
 		double d;				// fraction of population regenerated every generation
 		string cloningVersion;	// specifies whether to use static or proportional cloning
 		string selectionScheme;	// specifies which selection scheme to use CLONALG1 or CLONALG2
-
-		// sort vector of antibodies in regards to their fitness
-		static bool sortPopulationByFitness (IndividualP ab1,IndividualP ab2) { return ( ab1->fitness->isBetterThan(ab2->fitness)); }
-
-		// sort vector of antibodies first by their antibody parents and then by their fitness
-		static bool sortPopulationByParentAndFitness (IndividualP ab1,IndividualP ab2) 
-		{ 
-			FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (ab1->getGenotype(1));
-			double &parentAb1 = flp->realValue[0];
-			flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (ab2->getGenotype(1));
-			double &parentAb2 = flp->realValue[0];
-
-			if (parentAb1 <parentAb2) return true;
-			if (parentAb1 == parentAb2) return (ab1->fitness->isBetterThan(ab2->fitness));
-	
-			return false;
-		}
+		uint evalThreads;		// number of threads evaluating the clones (needs a reentrant evaluation operator, keep 1 with COCO)
+		uint exactMutation;		// 1: mutations match the scalar pow() computation bit for bit, 0: vectorized exp2
+		uint evalCache;			// size of the evaluation cache, 0: every changed clone is evaluated
+		uint streamBlock;		// clones generated, mutated and selected at a time, 0: the whole clone population at once
+
+		// generation instantiated for the configured cloning and selection policies (picked in initialize)
+		typedef bool (MyAlg::*Generation)(StateP state, DemeP deme);
+		Generation generation;
+		BatchEvaluator batchEvaluator;
+		HypermutationKernel mutationKernel;	// draws the mutations of all clones at once
+		std::vector<uint> mutationCount;	// number of mutations of each clone
+
+		// buffers kept (with their capacity) across the generations of a run
+		CloneArena clones;					// clone population of the current generation
+		FitnessRanking ranking;				// deme antibodies (cloningPhase) or clones (selectionPhase) ranked by fitness
+		std::vector<uint> selected;			// rows of the clones that survive the selectionPhase
+		std::vector<uint> antibodies;		// deme indices of the n best antibodies, best first (streaming)
+		CloneHeap survivors;				// best clones of the blocks streamed so far
+		std::vector<IndividualP> carriers;	// individuals that carry clones to the evaluation operator, one per thread
 
 public:
         
@@ -62,6 +100,10 @@ public:
 			registerParameter(state, "d", (voidP) new double(0.0), ECF::DOUBLE);
 			registerParameter(state, "cloningVersion", (voidP) new string("static"), ECF::STRING);
 			registerParameter(state, "selectionScheme", (voidP) new string("CLONALG2"), ECF::STRING);
+			registerParameter(state, "evalThreads", (voidP) new uint(1), ECF::INT);
+			registerParameter(state, "exactMutation", (voidP) new uint(1), ECF::INT);
+			registerParameter(state, "evalCache", (voidP) new uint(0), ECF::INT);
+			registerParameter(state, "streamBlock", (voidP) new uint(0), ECF::INT);
 		}
 
         
@@ -119,6 +161,37 @@ public:
 			if( selectionScheme != "CLONALG1" && selectionScheme != "CLONALG2"  ) {
 				ECF_LOG(state, 1, "Error: CLONALG requires parameter 'selectionScheme' to be either 'CLONALG1' or 'CLONALG2'");
 				throw "";}
+
+			voidP evalThreads_ = getParameterValue(state, "evalThreads");
+			evalThreads = *((uint*) evalThreads_.get());
+			if( *((int*) evalThreads_.get()) <= 0 ) {
+				ECF_LOG(state, 1, "Error: CLONALG requires parameter 'evalThreads' to be an integer greater than 0");
+				throw "";}
+			// FunctionMinEvalOp (COCO fgeneric) keeps its state in globals, so it is not reentrant
+			if( evalThreads > 1 )
+				ECF_LOG(state, 1, "Warning: CLONALG parameter 'evalThreads' > 1 needs a reentrant evaluation operator (FunctionMinEvalOp is not)");
+			batchEvaluator.setThreads(evalThreads);
+
+			voidP exactMutation_ = getParameterValue(state, "exactMutation");
+			exactMutation = *((uint*) exactMutation_.get());
+			if( exactMutation != 0 && exactMutation != 1 ) {
+				ECF_LOG(state, 1, "Error: CLONALG requires parameter 'exactMutation' to be either 0 or 1");
+				throw "";}
+			mutationKernel.setExact(exactMutation == 1);
+
+			voidP evalCache_ = getParameterValue(state, "evalCache");
+			evalCache = *((uint*) evalCache_.get());
+
+			voidP streamBlock_ = getParameterValue(state, "streamBlock");
+			streamBlock = *((uint*) streamBlock_.get());
+
+			// the strings are compared once here, the generation has the policies compiled in
+			if (cloningVersion == "static")
+				generation = (selectionScheme == "CLONALG1") ? &MyAlg::cloneAndSelect<StaticCloning, Clonalg1Selection>
+					: &MyAlg::cloneAndSelect<StaticCloning, Clonalg2Selection>;
+			else
+				generation = (selectionScheme == "CLONALG1") ? &MyAlg::cloneAndSelect<ProportionalCloning, Clonalg1Selection>
+					: &MyAlg::cloneAndSelect<ProportionalCloning, Clonalg2Selection>;
 						
 
 		    // algorithm accepts a single FloatingPoint Genotype
@@ -127,22 +200,24 @@ public:
 				ECF_LOG_ERROR(state, "Error: CLONALG algorithm accepts only a FloatingPoint genotype!");
 				throw ("");
 			}
-			//add parentAntibody genotype
-			if( selectionScheme == "CLONALG1"){
-				FloatingPointP flpoint[2];
-				for(uint iGen = 1; iGen < 2; iGen++) {
-					flpoint[iGen] = (FloatingPointP) new FloatingPoint::FloatingPoint;
-					state->setGenotype(flpoint[iGen]);
-
-					flpoint[iGen]->setParameterValue(state, "dimension", (voidP) new uint(1));					
-
-					// initial value of age parameter should be (or as close as possible to) 0				
-					flpoint[iGen]->setParameterValue(state, "lbound", (voidP) new double(0));
-					flpoint[iGen]->setParameterValue(state, "ubound", (voidP) new double(0.01));
-					
-				}
-				ECF_LOG(state, 1, "CLONALG algorithm: added 1 FloatingPoint genotype (parentAntibody)");
-			}
+
+			// the clone population never holds more than n antibodies and their clones (or a whole population);
+			// when streaming, it holds a single block of clones (or a whole population)
+			if (streamBlock > 0)
+				clones.reserve(std::max(streamBlock, populationSize), dimension);
+			else
+				clones.reserve(std::max(n + n * (uint) (beta * populationSize), populationSize), dimension);
+			selected.clear();
+			selected.reserve(n);
+			carriers.clear();
+
+			// cached fitness values belong to this run's function only
+			batchEvaluator.enableCache(evalCache, dimension);
+			batchEvaluator.resetCounters();
+
+			// phase timings and counters of a new run are totalled separately
+			PhaseProfiler::instance().beginRun();
+			RunCounters::instance().beginRun();
 
             return true;
         }
@@ -150,174 +225,223 @@ public:
        
         bool advanceGeneration(StateP state, DemeP deme)
         {	
-			  std::vector<IndividualP> clones;
-			  if (selectionScheme == "CLONALG1")
-				 markAntibodies(deme);
-			  cloningPhase(state, deme, clones);
-			  hypermutationPhase(state, deme, clones);
-			  selectionPhase(state, deme, clones);
+			  // carriers are created once, from the first deme this algorithm works on
+			  while (carriers.size() < evalThreads)
+				 carriers.push_back(copy(deme->at(0)));
+
+			  (this->*generation)(state, deme);
               birthPhase(state, deme, clones);
 			  replacePopulation(state, deme, clones);
+
+			  // clones of this generation that were not evaluated (if there are none, nothing is logged or allocated)
+			  if (batchEvaluator.getUnchanged() + batchEvaluator.getCacheHits() > 0)
+				  ECF_LOG(state, 3, "Evaluations skipped: " + uint2str(batchEvaluator.getUnchanged()) + " unchanged clones, "
+					  + uint2str(batchEvaluator.getCacheHits()) + " cache hits");
+			  batchEvaluator.resetCounters();
+
+			  // with -DECF_COUNT_ALLOCATIONS, log this generation's allocations
+			  AllocationCounter::log(state);
+			  // with -DECF_PROFILE_PHASES, report this generation's phase timings
+			  PhaseProfiler::instance().endGeneration();
 			 
               return true;
         }
 		
 		
-		bool markAntibodies(DemeP deme){
-			//mark antibodies so the alg can know which clone belongs to which parent Antibody
-			for( uint i = 0; i < deme->getSize(); i++ ) { // for each antibody
+		// cloning, hypermutation and selection (streamed or not) for the given policies
+		template <class Cloning, class Selection>
+		bool cloneAndSelect(StateP state, DemeP deme)
+		{
+			if (streamBlock > 0)
+				return streamingPhase<Cloning, Selection>(state, deme, clones);
 
-					FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (deme->at(i)->getGenotype(1));
-					double &parentAb = flp->realValue[0];
-					parentAb = i;				
-			}
+			cloningPhase<Cloning>(state, deme, clones);
+			hypermutationPhase(state, deme, clones);
+			selectionPhase<Selection>(state, deme, clones);
 			return true;
 		}
 
-		bool cloningPhase(StateP state, DemeP deme, std::vector<IndividualP> &clones)
+
+		template <class Cloning>
+		bool cloningPhase(StateP, DemeP deme, CloneArena &clones)
 		{	
+			PROFILE_PHASE("cloningPhase");
 			// calculate number of clones per antibody
 			uint clonesPerAntibody = beta * deme->getSize();
 
-			// storing all antibodies in a vector
-			for( uint i = 0; i < deme->getSize(); i++ )  // for each antibody	
-				clones.push_back(deme->at(i));
-
-			// sorting all antibodies
-			std::sort (clones.begin(), clones.end(), sortPopulationByFitness);
-			
-			// leaving n best antibodies for cloning
-			clones.erase (clones.begin()+n,clones.end());
+			// ranking only the n best antibodies, leaving them for cloning
+			ranking.load(*deme);
+			const std::vector<uint> &best = ranking.rankBest(n);
 			
-			for( uint i = 0; i < n; i++ ){ // for each antibody in clones vector
-				IndividualP antibody = clones.at(i);
+			// each antibody is followed by its clones, so the clones are already sorted by fitness
+			clones.clear();
+			for( uint i = 0; i < n; i++ ){ // for each of the n best antibodies
+				uint antibody = clones.add(deme->at(best[i]), 0, i);
 			
-				//static cloning : cloning each antibody beta*populationSize times
-				if (cloningVersion == "static"){
-					for (uint j = 0; j < clonesPerAntibody; j++) 
-						clones.push_back(copy(antibody));
-				}
-
-				//proportional cloning 
-				else{ 
-					uint proportionalCloneNo = clonesPerAntibody/(i+1);
-					for (uint j = 0; j < proportionalCloneNo ; j++) 
-						clones.push_back(copy(antibody));
-				}
+				// static cloning: each antibody is cloned beta*populationSize times, proportional: fewer for worse antibodies
+				uint cloneNo = Cloning::cloneNo(clonesPerAntibody, i);
+				for (uint j = 0; j < cloneNo; j++) 
+					clones.clone(antibody);
 		    }
 			
 			return true;
 		}
 
-		bool hypermutationPhase(StateP state, DemeP deme, std::vector<IndividualP> &clones)
+		bool hypermutationPhase(StateP state, DemeP, CloneArena &clones)
 		{			
-			// sorting all antibodies
-			std::sort (clones.begin(), clones.end(), sortPopulationByFitness);
-
+			PROFILE_PHASE("hypermutationPhase");
 			uint M;	// M - number of mutations of a single antibody 
 			uint k;
 
-			// calculate number of clones per antibody
-			uint clonesPerAntibody = beta * deme->getSize();
-
-			// these get used in case of proportional cloning
-			uint counter = 0;		
-			uint parentIndex = 0;
-			
+			// number of mutations of every clone
+			mutationCount.resize(clones.size());
+			uint nMutations = 0;
 			for( uint i = 0; i < clones.size(); i++ ){ // for each antibody in vector clones
-				IndividualP antibody = clones.at(i);
 				
-				FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (antibody->getGenotype(0));
-			    std::vector< double > &antibodyVars = flp->realValue;
-				
-				// inversely proportional hypermutation (better antibodies are mutated less)
-				if (cloningVersion == "static")
-					k = 1+ i/(clonesPerAntibody +1);
-				else{
-					if (counter == i){
-						parentIndex++;
-						counter += 1 + clonesPerAntibody/parentIndex;
-					}					
-					k = parentIndex;
-				}
+				// inversely proportional hypermutation (better antibodies are mutated less):
+				// k is the rank of the clone's antibody (1 for the best), the parent of a clone is its antibody's rank - 1 (see cloningPhase)
+				k = 1 + clones.parent[i];
 
 				M = (int) ((1- 1/(double)(k)) * (c*dimension) + (c*dimension));
-								
-				// mutate M times
-				for (uint j = 0; j < M; j++){
-					uint param = state->getRandomizer()->getRandomInteger((int)antibodyVars.size());
-					
-					double randDouble1 = state->getRandomizer()->getRandomDouble();
-					double randDouble2 = state->getRandomizer()->getRandomDouble();
-					double value = antibodyVars[param] + (1-2*randDouble1)* 0.2 *  (ubound - lbound) * pow(2, -16*randDouble2 );
-					
-					if (value > ubound)
-						value = ubound;
-					else if (value <lbound)
-						value = lbound;
-
-					//produce a mutation on the antibody 
-					antibodyVars[param] = value;
-				}
-				evaluate(antibody);
-			}		
+				mutationCount[i] = M;
+				nMutations += M;
+			}
+
+			// draw the mutations of all clones at once, then mutate each clone M times
+			mutationKernel.plan(state, nMutations, dimension, lbound, ubound);
+
+			uint first = 0;
+			for( uint i = 0; i < clones.size(); i++ ){ // for each antibody in vector clones
+				// a clone without mutations keeps sharing its antibody's coordinates
+				clones.dirty[i] = (mutationCount[i] > 0)
+					&& mutationKernel.apply(clones.row(i), first, first + mutationCount[i], lbound, ubound);
+				first += mutationCount[i];
+			}
+
+			// evaluate all changed clones at once (with evalCache, only those that are not cached)
+			batchEvaluator.evaluate(state, evalOp_, clones, 0, clones.size(), carriers);
 			return true;
 		}
 		
-		bool selectionPhase(StateP state, DemeP deme, std::vector<IndividualP> &clones)
+		template <class Selection>
+		bool selectionPhase(StateP, DemeP deme, CloneArena &clones)
 		{	
-			if( selectionScheme == "CLONALG1") {
+			PROFILE_PHASE("selectionPhase");
+			if( Selection::BEST_OF_PARENT ) {
 				
-				std::sort (clones.begin(), clones.end(), sortPopulationByParentAndFitness);
-			
-				int formerParent = -1;
-				std::vector<IndividualP> temp_clones;
-
+				// each antibody is substituted by the best clone of its set: the clones of an antibody
+				// are a contiguous run of rows (see cloningPhase), so one pass finds the best of every run
+				ranking.load(clones.fitness, clones.size());
+				selected.clear();
 				for (uint i = 0; i < clones.size(); i++){
-					FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (clones.at(i)->getGenotype(1));
-					double &parentAb = flp->realValue[0];
-					if (formerParent != parentAb){
-						temp_clones.push_back(clones.at(i));
-						formerParent = parentAb;
-					}
+					if (i == 0 || clones.parent[i] != clones.parent[i - 1])
+						selected.push_back(i);
+					else if (ranking.key(i) < ranking.key(selected.back()))
+						selected.back() = i;
 				}
-				clones = temp_clones;				
+				clones.keep(selected);
 			}
 
-			std::sort (clones.begin(), clones.end(), sortPopulationByFitness);
 			uint selNumber = (uint)((1-d)*deme->getSize());
 
 			//keep best (1-d)*populationSize antibodies ( or all if the number of clones is less than that )
-			if(selNumber < clones.size())
-				clones.erase (clones.begin()+ selNumber, clones.end());
+			clones.selectBest(selNumber);
+
+			return true;
+		}
+		
+		// cloning, hypermutation and selection, streamBlock clones at a time: the clones are generated in the same
+		// order (and mutated with the same random numbers) as by cloningPhase and hypermutationPhase, but only
+		// the best clones of the blocks seen so far are kept, so memory doesn't grow with n*beta*populationSize
+		template <class Cloning, class Selection>
+		bool streamingPhase(StateP state, DemeP deme, CloneArena &clones)
+		{
+			PROFILE_PHASE("streamingPhase");
+			uint clonesPerAntibody = beta * deme->getSize();
+			uint selNumber = (uint)((1-d)*deme->getSize());
+
+			// the ranking is reused for every block, so the n best antibodies are copied out
+			ranking.load(*deme);
+			const std::vector<uint> &best = ranking.rankBest(n);
+			antibodies.assign(best.begin(), best.begin() + std::min(n, (uint) best.size()));
+
+			survivors.reset(Selection::BEST_OF_PARENT ? n : selNumber, dimension);
+			clones.clear();
+			for( uint i = 0; i < antibodies.size(); i++ ){ // for each of the n best antibodies
+				uint cloneNo = Cloning::cloneNo(clonesPerAntibody, i);
+
+				// the antibody itself followed by its clones (sharing its coordinates within a block)
+				for (uint j = 0; j <= cloneNo; j++){
+					if (clones.size() == streamBlock){
+						selectBlock<Selection>(state, deme, clones);
+						clones.clear();
+					}
+					if (j > 0 && clones.size() > 0)
+						clones.clone(clones.size() - 1);
+					else
+						clones.add(deme->at(antibodies[i]), 0, i);
+				}
+			}
+			if (clones.size() > 0)
+				selectBlock<Selection>(state, deme, clones);
 
+			// CLONALG1 kept the best clone of every antibody, now the best selNumber of those are kept
+			if (Selection::BEST_OF_PARENT)
+				survivors.clones.selectBest(selNumber);
+
+			clones.clear();
+			for (uint i = 0; i < survivors.size(); i++)
+				clones.add(survivors.clones, i);
+
+			return true;
+		}
+
+		// mutate and evaluate a block of clones, then offer each of them to the survivors
+		template <class Selection>
+		bool selectBlock(StateP state, DemeP deme, CloneArena &block)
+		{
+			hypermutationPhase(state, deme, block);
+
+			ranking.load(block.fitness, block.size());
+			for (uint i = 0; i < block.size(); i++){
+				if (Selection::BEST_OF_PARENT)
+					survivors.pushBestOfParent(block, i, ranking.key(i));
+				else
+					survivors.push(block, i, ranking.key(i));
+			}
 			return true;
 		}
 		
-		bool birthPhase(StateP state, DemeP deme, std::vector<IndividualP> &clones)
+		bool birthPhase(StateP state, DemeP deme, CloneArena &clones)
 		{	
+			PROFILE_PHASE("birthPhase");
 			//  birthNumber - number of new antibodies randomly created and added 
 			uint birthNumber = deme->getSize() - clones.size();
 			
-			IndividualP newAntibody = copy(deme->at(0));
+			IndividualP newAntibody = carriers[0];
 			FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (newAntibody->getGenotype(0));
 
 			for (uint i = 0; i<birthNumber; i++){
 				//create a random antibody
 				flp->initialize(state);
-				evaluate(newAntibody);
+				{
+					PROFILE_PHASE("evaluate");
+					AllocationCounter::Evaluation evaluation;
+					evaluate(newAntibody);
+				}
 
 				//add it to the clones vector
-				clones.push_back(copy(newAntibody));
+				clones.add(newAntibody, 0, 0);
 			}			
 			return true;
 		}
 
-		bool replacePopulation(StateP state, DemeP deme, std::vector<IndividualP> &clones)
+		bool replacePopulation(StateP, DemeP deme, CloneArena &clones)
 		{
+			PROFILE_PHASE("replacePopulation");
 			//replace population with the contents of clones vector
 			for( uint i = 0; i < clones.size(); i++ ) // for each antibody
-				deme->replace(i, clones.at(i));
+				clones.copyTo(i, deme->at(i));
 			
 			clones.clear();
 			
@@ -353,68 +477,27 @@ typedef boost::shared_ptr<MyAlg> MyAlgP;
 
 
 //
-// this main() function iterates over multiple COCO functions and optimizes each one in turn
+// this main() function optimizes COCO functions 1-24, batch.repeats times each;
+// every (function, repeat) run is an independent job, spread over all cores (see BatchDriver.h)
 // function Ids: noiseless 1-24, noisy 101-130
 //
 
-int main(int argc, char **argv)
+// creates the State for a single (function, repeat) job
+StateP createState()
 {
-	// run for selected COCO functions
-	for(uint function = 1; function < 25; function++) {
+	StateP state (new State);
 
-		// read XML config
-		std::ifstream fin(argv[1]);
-		if (!fin) {
-			throw std::string("Error opening file! ");
-		}
+	//set newAlg
+	MyAlgP alg = (MyAlgP) new MyAlg;
+	state->addAlgorithm(alg);
+	// set the evaluation operator
+	state->setEvalOp(new FunctionMinEvalOp);
 
-		std::string xmlFile, temp;
-		while (!fin.eof()) {
-			getline(fin, temp);
-			xmlFile += "\n" + temp;
-		}
-		fin.close();
-
-		// set log and stats parameters
-		std::string funcName = uint2str(function);
-		std::string logName = "log", statsName = "stats";
-		if(function < 10) {
-			logName += "0";
-			statsName += "0";
-		}
-		logName += uint2str(function) + ".txt";
-		statsName += uint2str(function) + ".txt";
-
-		// update in XML
-		XMLResults results;
-		XMLNode xConfig = XMLNode::parseString(xmlFile.c_str(), "ECF", &results);
-		XMLNode registry = xConfig.getChildNode("Registry");
-
-		XMLNode func = registry.getChildNodeWithAttribute("Entry", "key", "coco.function");
-		func.updateText(funcName.c_str());
-		XMLNode log = registry.getChildNodeWithAttribute("Entry", "key", "log.filename");
-		log.updateText(logName.c_str());
-		XMLNode stats = registry.getChildNodeWithAttribute("Entry", "key", "batch.statsfile");
-		stats.updateText(statsName.c_str());
-
-		// write back
-		std::ofstream fout(argv[1]);
-		fout << xConfig.createXMLString(true);
-		fout.close();
-
-
-		// finally, run ECF on single function
-		StateP state (new State);
-
-		//set newAlg
-		MyAlgP alg = (MyAlgP) new MyAlg;
-		state->addAlgorithm(alg);
-		// set the evaluation operator
-		state->setEvalOp(new FunctionMinEvalOp);
-
-		state->initialize(argc, argv);
-		state->run();
-	}
+	return state;
+}
 
-	return 0;
+int main(int argc, char **argv)
+{
+	BatchDriver driver(argc, argv);
+	return driver.run(createState);
 }
@@ -1,5 +1,14 @@
 #include <ecf/ECF.h>
+#include <chrono>
 #include "FunctionMinEvalOp.h"
+#include "BatchDriver.h"
+#include "BatchEvaluator.h"
+#include "CloneArena.h"
+#include "HypermutationKernel.h"
+#include "IndividualAttribute.h"
+#include "AllocationCounter.h"
+#include "PhaseProfiler.h"
+#include "RunCounters.h"
 /**
  *\brief Optimization Immune  Algorithm (opt-IA) 
  * this opt-IA implements:  - static cloning : all antibodies are cloned dup times, making the size of the clone population equal dup*spoplationSize
@@ -8,8 +17,23 @@
  *							- birthPhase: if the number of antibodies that survive the aging Phase is less than populationSize, new randomly created abs are added to the population
  *							- optional elitism
  * opt-IA algorithm accepts only a single FloatingPoint genotype
- * Additionally, opt-IA adds a FloatingPoint genotype (age) 
+ * The clone population is kept in a CloneArena; antibodies are written back to the deme only in replacePopulation
+ * The age of each antibody is kept in an IndividualAttribute, not in a genotype
+ * elitism is a policy (below): initialize() picks the generation instantiated for it
  */
+
+// elitism policies: the best clone survives the aging phase regardless of its age, or not
+struct WithElitism
+{
+		enum { ENABLED = 1 };
+};
+
+struct WithoutElitism
+{
+		enum { ENABLED = 0 };
+};
+
+
 class MyAlg : public Algorithm
 {
 protected:
@@ -22,9 +46,34 @@ protected:
 		double c;		// mutation parameter
 		double tauB;	// maximum number of generations without improvement 
 		string elitism;	// specifies whether to use elitism or not
+		uint evalThreads;	// number of threads evaluating the clones (needs a reentrant evaluation operator, keep 1 with COCO)
+		uint exactMutation;	// 1: mutations match the scalar pow() computation bit for bit, 0: vectorized exp2
+		uint evalCache;	// size of the evaluation cache, 0: every changed clone is evaluated
+		uint cullAged;	// 1: clones whose aging outcome is known before evaluation are not evaluated
+
+		// generation instantiated for the configured elitism policy (picked in initialize)
+		typedef bool (MyAlg::*Generation)(StateP state, DemeP deme);
+		Generation generation;
+		BatchEvaluator batchEvaluator;
+		HypermutationKernel mutationKernel;	// draws the mutations of all clones at once
+		std::vector<uint> mutationCount;	// number of mutations of each clone
+
+		// buffers kept (with their capacity) across the generations of a run
+		CloneArena clones;						// clone population of the current generation
+		std::vector<uint> survivors;			// rows of the clones that survive the agingPhase
+		std::vector<FitnessP> parentFitness;	// fitness of each clone before hypermutation
+		std::vector<IndividualP> carriers;		// individuals that carry clones to the evaluation operator, one per thread
+		FitnessRanking ranking;					// deme antibodies ranked by fitness
+		IndividualAttribute<double> age;		// age of each antibody
+		std::vector<uint> pending;				// rows of the clones kept for evaluation, changed clones first (cullAged)
+		std::vector<FitnessP> pendingFitness;	// their parents' fitness
+
+		// cullAged statistics of the current run (function)
+		uint savedEvaluations;		// changed clones not evaluated because they die in the aging phase whatever their fitness
+		uint unchangedClones;		// unchanged clones not evaluated, since they keep their parent's fitness
+		uint timedEvaluations;		// evaluations of mutated clones, and the time they took
+		double evaluationTime;
 
-		// sort vector of antibodies in regards to their fitness
-		static bool sortPopulationByFitness (IndividualP ab1,IndividualP ab2) { return ( ab1->fitness->isBetterThan(ab2->fitness)); }
 public:
         
         MyAlg()
@@ -40,6 +89,10 @@ public:
 			registerParameter(state, "c", (voidP) new double(0.2), ECF::DOUBLE);
 			registerParameter(state, "tauB", (voidP) new double(100), ECF::DOUBLE);
 			registerParameter(state, "elitism", (voidP) new string("false"), ECF::STRING);
+			registerParameter(state, "evalThreads", (voidP) new uint(1), ECF::INT);
+			registerParameter(state, "exactMutation", (voidP) new uint(1), ECF::INT);
+			registerParameter(state, "evalCache", (voidP) new uint(0), ECF::INT);
+			registerParameter(state, "cullAged", (voidP) new uint(0), ECF::INT);
 		}
 
 
@@ -78,6 +131,38 @@ public:
 				ECF_LOG(state, 1,  "Error: opt-IA requires parameter 'elitism' to be either 'true' or 'false'");
 				throw "";}
 
+			voidP evalThreads_ = getParameterValue(state, "evalThreads");
+			evalThreads = *((uint*) evalThreads_.get());
+			if( *((int*) evalThreads_.get()) <= 0 ) {
+				ECF_LOG(state, 1, "Error: opt-IA requires parameter 'evalThreads' to be an integer greater than 0");
+				throw "";}
+			// FunctionMinEvalOp (COCO fgeneric) keeps its state in globals, so it is not reentrant
+			if( evalThreads > 1 )
+				ECF_LOG(state, 1, "Warning: opt-IA parameter 'evalThreads' > 1 needs a reentrant evaluation operator (FunctionMinEvalOp is not)");
+			batchEvaluator.setThreads(evalThreads);
+
+			voidP exactMutation_ = getParameterValue(state, "exactMutation");
+			exactMutation = *((uint*) exactMutation_.get());
+			if( exactMutation != 0 && exactMutation != 1 ) {
+				ECF_LOG(state, 1, "Error: opt-IA requires parameter 'exactMutation' to be either 0 or 1");
+				throw "";}
+			mutationKernel.setExact(exactMutation == 1);
+
+			voidP evalCache_ = getParameterValue(state, "evalCache");
+			evalCache = *((uint*) evalCache_.get());
+
+			voidP cullAged_ = getParameterValue(state, "cullAged");
+			cullAged = *((uint*) cullAged_.get());
+			if( cullAged != 0 && cullAged != 1 ) {
+				ECF_LOG(state, 1, "Error: opt-IA requires parameter 'cullAged' to be either 0 or 1");
+				throw "";}
+
+			// the string is compared once here, the generation has the policy compiled in
+			if (elitism == "true")
+				generation = &MyAlg::cloneAndSelect<WithElitism>;
+			else
+				generation = &MyAlg::cloneAndSelect<WithoutElitism>;
+
 
 			// algorithm accepts a single FloatingPoint Genotype
 			FloatingPointP flp (new FloatingPoint::FloatingPoint);
@@ -85,20 +170,34 @@ public:
 				ECF_LOG_ERROR(state, "Error: opt-IA algorithm accepts only a FloatingPoint genotype!");
 				throw ("");}
 
-			// algorithm adds another FloatingPoint genotype (age)
-			FloatingPointP flpoint[2];
-			for(uint iGen = 1; iGen < 2; iGen++) {
-				flpoint[iGen] = (FloatingPointP) new FloatingPoint::FloatingPoint;
-				state->setGenotype(flpoint[iGen]);
-
-				flpoint[iGen]->setParameterValue(state, "dimension", (voidP) new uint(1));					
-
-				// initial value of age parameter should be (or as close as possible to) 0				
-				flpoint[iGen]->setParameterValue(state, "lbound", (voidP) new double(0));
-				flpoint[iGen]->setParameterValue(state, "ubound", (voidP) new double(0.01));
-				
-			}
-			ECF_LOG(state, 1, "opt-IA algorithm: added 1 FloatingPoint genotype (antibody age)");
+			// every antibody of a new run starts with age 0
+			age.clear();
+
+			// the clone population holds every antibody and its dup clones
+			voidP populationSize_ = state->getRegistry()->getEntry("population.size");
+			uint populationSize = *((uint*) populationSize_.get());
+			clones.reserve(populationSize * (dup + 1), dimension);
+			survivors.clear();
+			survivors.reserve(populationSize * (dup + 1));
+			parentFitness.clear();
+			parentFitness.reserve(populationSize * (dup + 1));
+			pending.clear();
+			pending.reserve(populationSize * (dup + 1));
+			pendingFitness.clear();
+			pendingFitness.reserve(populationSize * (dup + 1));
+			carriers.clear();
+			savedEvaluations = 0;
+			unchangedClones = 0;
+			timedEvaluations = 0;
+			evaluationTime = 0;
+
+			// cached fitness values belong to this run's function only
+			batchEvaluator.enableCache(evalCache, dimension);
+			batchEvaluator.resetCounters();
+
+			// phase timings and counters of a new run are totalled separately
+			PhaseProfiler::instance().beginRun();
+			RunCounters::instance().beginRun();
 			
             return true;
 		}
@@ -106,154 +205,257 @@ public:
 
 		bool advanceGeneration(StateP state, DemeP deme)
 		{	
-			std::vector<IndividualP> clones;
-			 
-			cloningPhase(state, deme, clones);
-			hypermutationPhase(state, deme, clones);
-			agingPhase(state, deme, clones);
-			selectionPhase(state, deme, clones);
+			// carriers are created once, from the first deme this algorithm works on
+			while (carriers.size() < evalThreads)
+				carriers.push_back(copy(deme->at(0)));
+
+			(this->*generation)(state, deme);
             birthPhase(state, deme, clones);
 			replacePopulation(state, deme, clones);
 
+			// clones of this generation that were not evaluated (if there are none, nothing is logged or allocated)
+			if (batchEvaluator.getUnchanged() + batchEvaluator.getCacheHits() > 0)
+				ECF_LOG(state, 3, "Evaluations skipped: " + uint2str(batchEvaluator.getUnchanged()) + " unchanged clones, "
+					+ uint2str(batchEvaluator.getCacheHits()) + " cache hits");
+			batchEvaluator.resetCounters();
+
+			// the time gained is estimated from the average time of the evaluations that were made
+			if (cullAged == 1 && timedEvaluations > 0)
+				ECF_LOG(state, 3, "Aging cull (run so far): " + uint2str(savedEvaluations) + " evaluations saved, about "
+					+ dbl2str(savedEvaluations * evaluationTime / timedEvaluations) + " s, "
+					+ uint2str(unchangedClones) + " unchanged clones not evaluated");
+
+			// with -DECF_COUNT_ALLOCATIONS, log this generation's allocations
+			AllocationCounter::log(state);
+			// with -DECF_PROFILE_PHASES, report this generation's phase timings
+			PhaseProfiler::instance().endGeneration();
+
+			return true;
+		}
+
+
+		// cloning, hypermutation, aging and selection for the given elitism policy
+		template <class Elitism>
+		bool cloneAndSelect(StateP state, DemeP deme)
+		{
+			cloningPhase(state, deme, clones);
+			hypermutationPhase<Elitism>(state, deme, clones);
+			agingPhase<Elitism>(state, deme, clones);
+			selectionPhase(state, deme, clones);
 			return true;
 		}
 
 
-		bool cloningPhase(StateP state, DemeP deme, std::vector<IndividualP> &clones)
+		bool cloningPhase(StateP, DemeP deme, CloneArena &clones)
 		{
-			// storing all antibodies in a vector
-			for( uint i = 0; i < deme->getSize(); i++ )  // for each antibody	
-				clones.push_back(deme->at(i));
+			PROFILE_PHASE("cloningPhase");
+			// ranking all antibodies by fitness
+			ranking.load(*deme);
+			const std::vector<uint> &order = ranking.rank();
 
-			for( uint i = 0; i < deme->getSize(); i++ ){ // for each antibody in clones vector
-				IndividualP antibody = clones.at(i);
+			// each antibody is followed by its clones, so the clones are already sorted by fitness
+			std::vector<double> &antibodyAge = age.of(deme);
+			clones.clear();
+			for( uint i = 0; i < order.size(); i++ ){ // for each antibody
+				IndividualP ab = deme->at(order[i]);
+				uint antibody = clones.add(ab, antibodyAge[ab->index], i);
 				
 				// static cloning is fitness independent : : cloning each antibody dup times
 				for (uint j = 0; j < dup; j++) 
-					clones.push_back(copy(antibody));					
+					clones.clone(antibody);
 			}
 
 			return true;
 		}
 
 
-		bool hypermutationPhase(StateP state, DemeP deme, std::vector<IndividualP> &clones)
+		template <class Elitism>
+		bool hypermutationPhase(StateP state, DemeP deme, CloneArena &clones)
 		{	
+			PROFILE_PHASE("hypermutationPhase");
 			uint M;	// M - number of mutations of a single antibody 
 			uint k;
 
-			//sort 
-			std::sort (clones.begin(), clones.end(), sortPopulationByFitness);
+			// clones are grouped by antibody, best antibody first (see cloningPhase), so no sorting is needed
+			parentFitness.resize(clones.size());
 
+			// number of mutations of every clone
+			mutationCount.resize(clones.size());
+			uint nMutations = 0;
 			for( uint i = 0; i < clones.size(); i++ ){ // for each antibody in vector clones
-				IndividualP antibody = clones.at(i);
-				
-				FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (antibody->getGenotype(0));
-			    std::vector< double > &antibodyVars = flp->realValue;
+				parentFitness[i] = clones.fitness[i];
 				
 				k = 1 + i/(dup+1);
 				M =(int) ((1- 1/(double)(k)) * (c*dimension) + (c*dimension));
-				
-				// mutate M times
-				for (uint j = 0; j < M; j++){
-					uint param = state->getRandomizer()->getRandomInteger((int)antibodyVars.size());
-					
-					double randDouble1 = state->getRandomizer()->getRandomDouble();
-					double randDouble2 = state->getRandomizer()->getRandomDouble();
-					double value = antibodyVars[param] + (1-2*randDouble1)* 0.2 *  (ubound - lbound) * pow(2, -16*randDouble2 );
-					
-					if (value > ubound)
-						value = ubound;
-					else if (value <lbound)
-						value = lbound;
-
-					//produce a mutation on the antibody 
-					antibodyVars[param] = value;
-				}
-				FitnessP parentFitness = antibody->fitness;
-				evaluate(antibody);
+				mutationCount[i] = M;
+				nMutations += M;
+			}
+
+			// draw the mutations of all clones at once, then mutate each clone M times
+			mutationKernel.plan(state, nMutations, dimension, lbound, ubound);
+
+			uint evaluated = clones.size();
 
+			uint first = 0;
+			for( uint i = 0; i < clones.size(); i++ ){ // for each antibody in vector clones
+				// a clone without mutations keeps sharing its antibody's coordinates
+				clones.dirty[i] = (mutationCount[i] > 0)
+					&& mutationKernel.apply(clones.row(i), first, first + mutationCount[i], lbound, ubound);
+				first += mutationCount[i];
+			}
+
+			// clones that die in agingPhase whatever their fitness are dropped, unchanged ones keep their parent's fitness
+			if (cullAged == 1)
+				evaluated = cullPhase<Elitism>(state, deme, clones);
+
+			// evaluate all changed clones at once (with evalCache, only those that are not cached)
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			uint evaluations = state->getEvaluations();
+			batchEvaluator.evaluate(state, evalOp_, clones, 0, evaluated, carriers);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			evaluationTime += seconds;
+			timedEvaluations += state->getEvaluations() - evaluations;
+			if (cullAged == 1) {
+				static const uint secondsId = RunCounters::instance().counter("cullEvaluationSeconds");
+				static const uint evaluationsId = RunCounters::instance().counter("cullEvaluations");
+				RunCounters::instance().add(secondsId, seconds);
+				RunCounters::instance().add(evaluationsId, state->getEvaluations() - evaluations);
+			}
+
+			for( uint i = 0; i < clones.size(); i++ ){
 				// if the clone is better than its parent, reset clone's age
-				if(antibody-> fitness->isBetterThan(parentFitness)){					
-					flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (antibody->getGenotype(1));
-					double &age = flp->realValue[0];
-					age = 0;
-				} 
+				if(clones.fitness[i]->isBetterThan(parentFitness[i]))
+					clones.age[i] = 0;
 			}
 			return true;
 		}
 
 
-		bool agingPhase(StateP state, DemeP deme,  std::vector<IndividualP> &clones)
+		// the clone dies in agingPhase whatever its fitness turns out to be
+		template <class Elitism>
+		bool isCertainlyAged(CloneArena &clones, uint i)
+		{
+			// with elitism the best clone survives regardless of its age, so every fitness matters
+			if (Elitism::ENABLED)
+				return false;
+
+			// an unchanged clone keeps its parent's fitness and age, a changed one is at best reset to age 0
+			double youngest = clones.dirty[i] ? 0 : clones.age[i];
+			return youngest + 1 > tauB;
+		}
+
+		// drop the clones that are certainly aged and move the changed clones to the front, return their number:
+		// only those need evaluation, the others keep their parent's fitness.
+		// A changed clone survives if it improves on its parent (its age is reset), so without elitism it is
+		// certainly aged only when tauB < 1; the cull mostly drops unchanged clones of antibodies at age tauB.
+		template <class Elitism>
+		uint cullPhase(StateP, DemeP, CloneArena &clones)
+		{
+			PROFILE_PHASE("cullPhase");
+			static const uint savedId = RunCounters::instance().counter("culledChangedClones");
+			static const uint unchangedId = RunCounters::instance().counter("cullUnchangedClones");
+			pending.clear();
+			pendingFitness.clear();
+			uint nCulled = 0;	// changed clones dropped
+			for (uint pass = 0; pass < 2; pass++){
+				bool changed = (pass == 0);
+				for (uint i = 0; i < clones.size(); i++){
+					if ((clones.dirty[i] != 0) != changed)
+						continue;
+					if (isCertainlyAged<Elitism>(clones, i)) {
+						nCulled += changed;
+						continue;
+					}
+					pending.push_back(i);
+					pendingFitness.push_back(parentFitness[i]);
+				}
+			}
+
+			uint nChanged = 0;
+			while (nChanged < pending.size() && clones.dirty[pending[nChanged]])
+				nChanged++;
+
+			// only the dropped changed clones are evaluations saved by aging; unchanged clones are never evaluated
+			savedEvaluations += nCulled;
+			unchangedClones += clones.size() - nChanged - nCulled;
+			RunCounters::instance().add(savedId, nCulled);
+			RunCounters::instance().add(unchangedId, clones.size() - nChanged - nCulled);
+			clones.keep(pending);
+			parentFitness.swap(pendingFitness);
+			return nChanged;
+		}
+
+		template <class Elitism>
+		bool agingPhase(StateP, DemeP, CloneArena &clones)
 		{	
-			//sort 
-			std::sort (clones.begin(), clones.end(), sortPopulationByFitness);
+			PROFILE_PHASE("agingPhase");
+			// only the best antibody is treated differently (elitism), no sorting is needed
+			uint best = Elitism::ENABLED ? clones.best() : (uint) clones.size();
 
-			std::vector<IndividualP> temp_clones;
+			survivors.clear();
 
 			for (uint i = 0; i < clones.size(); i++){// for each antibody
-				IndividualP antibody = clones.at(i);
 
 				//age each antibody
-				FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (antibody->getGenotype(1));
-				double &age = flp->realValue[0];
+				double &age = clones.age[i];
 				age += 1;
 				
 				// static aging: if an antibody exceeds tauB number of trials, it is replaced with a new randomly created antibody
 				if (age <=tauB)
-					temp_clones.push_back(antibody);
+					survivors.push_back(i);
 				// if elitism = true , preserve the best antibody regardless of its age
-				else if (elitism == "true" && i == 0)
-					temp_clones.push_back(antibody);
+				else if (Elitism::ENABLED && i == best)
+					survivors.push_back(i);
 			}
-			clones = temp_clones;
+			clones.keep(survivors);
 			return true;
 		}
 
-		bool selectionPhase(StateP state, DemeP deme, std::vector<IndividualP> &clones)
+		bool selectionPhase(StateP, DemeP deme, CloneArena &clones)
 		{	
-			//sort 
-			std::sort (clones.begin(), clones.end(), sortPopulationByFitness);
-		
+			PROFILE_PHASE("selectionPhase");
 			//keep best populationSize antibodies ( or all if the number of clones is less than that ), erase the rest
-			if(clones.size() > deme->getSize())
-				clones.erase (clones.begin()+ deme->getSize(), clones.end());
+			clones.selectBest(deme->getSize());
 
 			return true;
 		}
 
-		bool birthPhase(StateP state, DemeP deme, std::vector<IndividualP> &clones)
+		bool birthPhase(StateP state, DemeP deme, CloneArena &clones)
 		{
+			PROFILE_PHASE("birthPhase");
 			//number of new antibodies (randomly created)
 			uint birthNumber = deme->getSize() - clones.size();
 
 			//if no new antibodies are needed, return (this if part is optional, code works fine w/o it)
 			if (birthNumber == 0) return true;
 
-			IndividualP newAntibody = copy(deme->at(0));
+			IndividualP newAntibody = carriers[0];
 			FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (newAntibody->getGenotype(0));
 	
 			for (uint i = 0; i<birthNumber; i++){
 				//create a random antibody
 				flp->initialize(state);
-				evaluate(newAntibody);
-			
-				//reset its age
-				flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (newAntibody->getGenotype(1));
-				double &age = flp->realValue[0];
-				age = 0;
+				{
+					PROFILE_PHASE("evaluate");
+					AllocationCounter::Evaluation evaluation;
+					evaluate(newAntibody);
+				}
 
-				//add it to the clones vector
-				clones.push_back(copy(newAntibody));
+				//add it to the clones vector, with its age reset
+				clones.add(newAntibody, 0, 0);
 			}
 			return true;
 		}
 
-		bool replacePopulation(StateP state, DemeP deme, std::vector<IndividualP> &clones)
+		bool replacePopulation(StateP, DemeP deme, CloneArena &clones)
 		{
+			PROFILE_PHASE("replacePopulation");
 			//replace population with the contents of the clones vector
-			for( uint i = 0; i < clones.size(); i++ ) // for each antibody
-				deme->replace(i, clones.at(i));
+			std::vector<double> &antibodyAge = age.of(deme);
+			for( uint i = 0; i < clones.size(); i++ ){ // for each antibody
+				clones.copyTo(i, deme->at(i));
+				antibodyAge[deme->at(i)->index] = clones.age[i];
+			}
 			
 			clones.clear();
 			
@@ -291,68 +493,27 @@ typedef boost::shared_ptr<MyAlg> MyAlgP;
 
 
 //
-// this main() function iterates over multiple COCO functions and optimizes each one in turn
+// this main() function optimizes COCO functions 1-24, batch.repeats times each;
+// every (function, repeat) run is an independent job, spread over all cores (see BatchDriver.h)
 // function Ids: noiseless 1-24, noisy 101-130
 //
 
-int main(int argc, char **argv)
+// creates the State for a single (function, repeat) job
+StateP createState()
 {
-	// run for selected COCO functions
-	for(uint function = 1; function < 25; function++) {
-
-		// read XML config
-		std::ifstream fin(argv[1]);
-		if (!fin) {
-			throw std::string("Error opening file! ");
-		}
-
-		std::string xmlFile, temp;
-		while (!fin.eof()) {
-			getline(fin, temp);
-			xmlFile += "\n" + temp;
-		}
-		fin.close();
-
-		// set log and stats parameters
-		std::string funcName = uint2str(function);
-		std::string logName = "log", statsName = "stats";
-		if(function < 10) {
-			logName += "0";
-			statsName += "0";
-		}
-		logName += uint2str(function) + ".txt";
-		statsName += uint2str(function) + ".txt";
+	StateP state (new State);
 
-		// update in XML
-		XMLResults results;
-		XMLNode xConfig = XMLNode::parseString(xmlFile.c_str(), "ECF", &results);
-		XMLNode registry = xConfig.getChildNode("Registry");
+	//set newAlg
+	MyAlgP alg = (MyAlgP) new MyAlg;
+	state->addAlgorithm(alg);
+	// set the evaluation operator
+	state->setEvalOp(new FunctionMinEvalOp);
 
-		XMLNode func = registry.getChildNodeWithAttribute("Entry", "key", "coco.function");
-		func.updateText(funcName.c_str());
-		XMLNode log = registry.getChildNodeWithAttribute("Entry", "key", "log.filename");
-		log.updateText(logName.c_str());
-		XMLNode stats = registry.getChildNodeWithAttribute("Entry", "key", "batch.statsfile");
-		stats.updateText(statsName.c_str());
-
-		// write back
-		std::ofstream fout(argv[1]);
-		fout << xConfig.createXMLString(true);
-		fout.close();
-
-
-		// finally, run ECF on single function
-		StateP state (new State);
-
-		//set newAlg
-		MyAlgP alg = (MyAlgP) new MyAlg;
-		state->addAlgorithm(alg);
-		// set the evaluation operator
-		state->setEvalOp(new FunctionMinEvalOp);
-
-		state->initialize(argc, argv);
-		state->run();
-	}
+	return state;
+}
 
-	return 0;
+int main(int argc, char **argv)
+{
+	BatchDriver driver(argc, argv);
+	return driver.run(createState);
 }
@@ -0,0 +1,94 @@
+#ifndef AcceptanceWalk_h
+#define AcceptanceWalk_h
+
+#include <ecf/ECF.h>
+#include <cmath>
+#include <algorithm>
+
+/**
+ * \brief Round-robin acceptance walk, sampled in O(log n) per accepted item
+ *
+ * The walk visits items 0, 1, ..., n-1, 0, 1, ... and accepts item i if a random double is below p[i];
+ * every sample() returns the next accepted item, and the walk goes on from the item after it.
+ * This is ABC's onlooker loop: instead of drawing a number for every visited item, sample() draws a single
+ * number and finds the accepted item by binary search over the log survival probabilities of the walk
+ * (the probability that the walk passes a stretch of items without accepting any of them), so the accepted
+ * items have exactly the distribution of the visiting loop, also when the walk goes around the items more than once.
+ *
+ * p[i] below 0 (never accepted) and above 1 (always accepted) act as 0 and 1, as in the loop.
+ * If no item can be accepted the loop would never end; the walk then returns the items in turn.
+ * build() takes O(n) and keeps its buffers, so a walk rebuilt every generation doesn't allocate.
+ */
+class AcceptanceWalk
+{
+public:
+		// build the walk from acceptance probabilities; it starts at item 0
+		void build(const std::vector<double> &probabilities)
+		{
+			uint n = (uint) probabilities.size();
+			logStay_.resize(2 * n + 1);
+			certain_.resize(2 * n + 1);
+			position_ = 0;
+
+			// over two rounds, so that a stretch starting at any item is contiguous
+			logStay_[0] = 0;
+			for(uint x = 0; x < 2 * n; x++) {
+				double p = probabilities[x % n];
+				p = (p > 0) ? std::min(p, 1.) : 0.;
+				// an item accepted for sure ends every stretch through it: the sums start again after it
+				logStay_[x + 1] = (p == 1.) ? 0. : logStay_[x] + log1p(-p);
+			}
+			certain_[2 * n] = 2 * n;
+			for(uint x = 2 * n; x-- > 0; ) {
+				double p = probabilities[x % n];
+				certain_[x] = (p >= 1.) ? x : certain_[x + 1];
+			}
+
+			// probability that a whole round accepts some item
+			if(n == 0)
+				roundAccept_ = 0;
+			else if(certain_[0] < n)
+				roundAccept_ = 1;
+			else
+				roundAccept_ = -expm1(logStay_[n]);
+		}
+
+		uint size()
+		{	return (uint) certain_.size() / 2;	}
+
+		// the next item the walk accepts
+		uint sample(RandomizerP randomizer)
+		{
+			uint n = size();
+			uint start = position_;
+			if(roundAccept_ <= 0) {
+				position_ = (start + 1) % n;
+				return start;
+			}
+
+			// the walk from start accepts before visit x with probability (1 - stay(start, x)) / roundAccept_;
+			// find the first x where that exceeds u
+			double u = randomizer->getRandomDouble();
+			double logTarget = log1p(-u * roundAccept_);
+			uint low = start + 1;
+			uint high = std::min(certain_[start] + 1, start + n);
+			while(low < high) {
+				uint middle = low + (high - low) / 2;
+				if(logStay_[middle] - logStay_[start] < logTarget)
+					high = middle;
+				else
+					low = middle + 1;
+			}
+
+			position_ = low % n;
+			return (low - 1) % n;
+		}
+
+protected:
+		std::vector<double> logStay_;	// sum of log(1 - p) over the visits since the last certain acceptance, two rounds
+		std::vector<uint> certain_;		// first visit from x on that is accepted for sure (2n if none)
+		double roundAccept_;
+		uint position_;					// next item to visit
+};
+
+#endif // AcceptanceWalk_h
@@ -0,0 +1,82 @@
+#ifndef AliasTable_h
+#define AliasTable_h
+
+#include <ecf/ECF.h>
+
+/**
+ * \brief Walker's alias table: samples index i with probability weight[i] / sum of weights in O(1)
+ *
+ * build() takes O(n) (Vose's construction) and keeps its buffers, so a table rebuilt every generation doesn't allocate.
+ * Negative weights count as 0 (never sampled).
+ * A sample costs a single random double: its integer part (scaled by n) picks a column,
+ * its fractional part decides between the column and its alias.
+ */
+class AliasTable
+{
+public:
+		// build the table from the weights (negative ones count as 0; if no weight is positive, the distribution is uniform)
+		void build(const std::vector<double> &weights)
+		{
+			uint n = (uint) weights.size();
+			threshold_.resize(n);
+			alias_.resize(n);
+			small_.clear();
+			large_.clear();
+
+			double sum = 0;
+			for(uint i = 0; i < n; i++)
+				sum += weight(weights[i]);
+
+			for(uint i = 0; i < n; i++) {
+				threshold_[i] = (sum > 0) ? weight(weights[i]) * n / sum : 1.;
+				alias_[i] = i;
+				if(threshold_[i] < 1.)
+					small_.push_back(i);
+				else
+					large_.push_back(i);
+			}
+
+			// pair every underfull column with an overfull one
+			while(!small_.empty() && !large_.empty()) {
+				uint less = small_.back();
+				small_.pop_back();
+				uint more = large_.back();
+				alias_[less] = more;
+				threshold_[more] -= 1. - threshold_[less];
+				if(threshold_[more] < 1.) {
+					large_.pop_back();
+					small_.push_back(more);
+				}
+			}
+
+			// whatever is left is full up to rounding
+			for(uint i = 0; i < small_.size(); i++)
+				threshold_[small_[i]] = 1.;
+			for(uint i = 0; i < large_.size(); i++)
+				threshold_[large_[i]] = 1.;
+		}
+
+		uint size()
+		{	return (uint) alias_.size();	}
+
+		// random index, distributed according to the weights
+		uint sample(RandomizerP randomizer)
+		{
+			double u = randomizer->getRandomDouble() * alias_.size();
+			uint column = (uint) u;
+			if(column >= alias_.size())
+				column = (uint) alias_.size() - 1;
+			return (u - column < threshold_[column]) ? column : alias_[column];
+		}
+
+protected:
+		std::vector<double> threshold_;	// probability of keeping the column (otherwise its alias is taken)
+		std::vector<uint> alias_;
+		std::vector<uint> small_;
+		std::vector<uint> large_;
+
+		static double weight(double w)
+		{	return (w > 0) ? w : 0.;	}
+};
+
+#endif // AliasTable_h
@@ -0,0 +1,119 @@
+#ifndef AllocationCounter_h
+#define AllocationCounter_h
+
+#include <ecf/ECF.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/**
+ * \brief Counts heap allocations, to check that steady-state generations don't allocate
+ *
+ * Compiled in only with -DECF_COUNT_ALLOCATIONS: the header then replaces the global operator new and delete,
+ * so it may be included by a single translation unit (an algorithm's main.cpp).
+ * Allocations made inside evaluation calls (an AllocationCounter::Evaluation scope, opened around every evalOp->evaluate)
+ * are counted apart from the others: the evaluation operator belongs to COCO, and FunctionMinEvalOp returns a new Fitness
+ * for every evaluation, which no algorithm can recycle.
+ * Algorithms call log() at the end of every generation; it logs both numbers for the allocations made since the previous call,
+ * e.g. "Allocations: 0 (evaluation operator: 320)". The log message itself is not counted.
+ * Without the macro log() does nothing and allocation isn't affected.
+ *
+ * There is no pool of individuals: clones live in a CloneArena and ABC moves its food sources in place,
+ * so generations no longer copy() individuals, and after the first generation every algorithm logs 0 allocations
+ * outside evaluation. What is left is the evaluation operator's Fitness, which a pool can't recycle.
+ */
+class AllocationCounter
+{
+public:
+		// allocations outside evaluation calls
+		static std::atomic<unsigned long>& count()
+		{
+			static std::atomic<unsigned long> allocations (0);
+			return allocations;
+		}
+
+		// allocations inside evaluation calls
+		static std::atomic<unsigned long>& evaluationCount()
+		{
+			static std::atomic<unsigned long> allocations (0);
+			return allocations;
+		}
+
+		// is the calling thread inside an evaluation call
+		static bool& isEvaluating()
+		{
+			static thread_local bool evaluating = false;
+			return evaluating;
+		}
+
+#ifdef ECF_COUNT_ALLOCATIONS
+		/**
+		 * \brief Counts the allocations of the calling thread as the evaluation operator's until the end of the scope
+		 */
+		class Evaluation
+		{
+		public:
+				Evaluation()
+				{
+					outer_ = isEvaluating();
+					isEvaluating() = true;
+				}
+
+				~Evaluation()
+				{	isEvaluating() = outer_;	}
+
+		protected:
+				bool outer_;
+		};
+
+		static void log(StateP state)
+		{
+			static unsigned long previous = 0, previousEvaluation = 0;
+			unsigned long allocations = count().load() - previous;
+			unsigned long evaluation = evaluationCount().load() - previousEvaluation;
+			ECF_LOG(state, 3, "Allocations: " + uint2str((uint) allocations) + " (evaluation operator: " + uint2str((uint) evaluation) + ")");
+			// the next generation starts after the message was built
+			previous = count().load();
+			previousEvaluation = evaluationCount().load();
+		}
+#else
+		class Evaluation
+		{
+		public:
+				Evaluation()
+				{}
+		};
+
+		static void log(StateP)
+		{}
+#endif
+};
+
+#ifdef ECF_COUNT_ALLOCATIONS
+// neither is inlined, so that the compiler doesn't pair the malloc() and free() inside them with the built-in new and delete
+#if defined(__GNUC__)
+#define ALLOCATION_COUNTER_NOINLINE __attribute__((noinline))
+#else
+#define ALLOCATION_COUNTER_NOINLINE
+#endif
+
+ALLOCATION_COUNTER_NOINLINE void* operator new(std::size_t size)
+{
+	if(AllocationCounter::isEvaluating())
+		AllocationCounter::evaluationCount()++;
+	else
+		AllocationCounter::count()++;
+	void *memory = std::malloc(size ? size : 1);
+	if(memory == NULL)
+		throw std::bad_alloc();
+	return memory;
+}
+
+ALLOCATION_COUNTER_NOINLINE void operator delete(void *memory) noexcept
+{	std::free(memory);	}
+
+void operator delete(void *memory, std::size_t) noexcept
+{	::operator delete(memory);	}
+#endif
+
+#endif // AllocationCounter_h
@@ -0,0 +1,659 @@
+#ifndef BatchDriver_h
+#define BatchDriver_h
+
+#include <ecf/ECF.h>
+#include "ConfigTemplate.h"
+#include "PhiloxRandomizer.h"
+#include "PhaseProfiler.h"
+#include "RunCounters.h"
+#include "TraceSink.h"
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <algorithm>
+#include <memory>
+#include <functional>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <csignal>
+#include <chrono>
+#include <cmath>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+/**
+ * \brief Work-stealing thread pool
+ *
+ * Tasks are dealt round-robin into per-worker queues before run() is called.
+ * Each worker pops tasks from the back of its own queue; when it runs dry it steals from the front
+ * of the other queues, so a worker stuck with expensive tasks gets unloaded by the idle ones.
+ * No tasks are added while the pool is running, so a worker quits once every queue is empty.
+ */
+class WorkStealingPool
+{
+public:
+		typedef std::function<void ()> Task;
+
+		explicit WorkStealingPool(uint nThreads)
+		{
+			if(nThreads < 1)
+				nThreads = 1;
+			for(uint i = 0; i < nThreads; i++)
+				queues_.push_back(std::unique_ptr<TaskQueue>(new TaskQueue));
+			next_ = 0;
+		}
+
+		uint getSize()
+		{	return (uint) queues_.size();	}
+
+		void push(Task task)
+		{
+			TaskQueue &queue = *queues_[next_];
+			next_ = (next_ + 1) % queues_.size();
+
+			std::lock_guard<std::mutex> guard(queue.lock);
+			queue.tasks.push_back(task);
+		}
+
+		// run all pushed tasks, return when every queue is empty
+		void run()
+		{
+			std::vector<std::thread> workers;
+			for(uint i = 0; i < queues_.size(); i++)
+				workers.push_back(std::thread(&WorkStealingPool::work, this, i));
+			for(uint i = 0; i < workers.size(); i++)
+				workers[i].join();
+		}
+
+protected:
+		struct TaskQueue
+		{
+			std::mutex lock;
+			std::deque<Task> tasks;
+		};
+		std::vector< std::unique_ptr<TaskQueue> > queues_;
+		uint next_;
+
+		// take the most recently pushed task from worker's own queue
+		bool pop(uint worker, Task &task)
+		{
+			TaskQueue &queue = *queues_[worker];
+			std::lock_guard<std::mutex> guard(queue.lock);
+			if(queue.tasks.empty())
+				return false;
+			task = queue.tasks.back();
+			queue.tasks.pop_back();
+			return true;
+		}
+
+		// take the oldest task from some other worker's queue
+		bool steal(uint worker, Task &task)
+		{
+			for(uint i = 1; i < queues_.size(); i++) {
+				TaskQueue &queue = *queues_[(worker + i) % queues_.size()];
+				std::lock_guard<std::mutex> guard(queue.lock);
+				if(queue.tasks.empty())
+					continue;
+				task = queue.tasks.front();
+				queue.tasks.pop_front();
+				return true;
+			}
+			return false;
+		}
+
+		void work(uint worker)
+		{
+			TraceSink::instance().nameThread("worker");
+			Task task;
+			while(pop(worker, task) || steal(worker, task))
+				task();
+		}
+};
+
+
+/**
+ * \brief A batch job: nRepeats consecutive repeats (starting with repeat) of one COCO function
+ */
+struct BatchJob
+{
+		uint function;
+		uint repeat;
+		uint nRepeats;
+};
+
+
+/**
+ * \brief Hands a config held in memory to State::initialize, which only reads config files
+ *
+ * name() is a file the State can open once and read the config from: /dev/fd/N of a pipe (POSIX),
+ * or a named pipe (Windows). A thread writes the config into it; the destructor waits for that thread,
+ * so the ConfigPipe must live until State::initialize returns.
+ */
+class ConfigPipe
+{
+public:
+		explicit ConfigPipe(const std::string &config)
+		{
+			config_ = config;
+#ifdef _WIN32
+			static std::atomic<uint> nPipes (0);
+			name_ = "\\\\.\\pipe\\ECFconfig" + uint2str((uint) GetCurrentProcessId()) + "_" + uint2str(nPipes++);
+			pipe_ = CreateNamedPipeA(name_.c_str(), PIPE_ACCESS_OUTBOUND, PIPE_TYPE_BYTE | PIPE_WAIT, 1,
+				(DWORD) config_.size(), 0, 0, NULL);
+			if(pipe_ == INVALID_HANDLE_VALUE)
+				throw std::string("Error: BatchDriver can't create a config pipe! ");
+#else
+			int ends[2];
+			if(pipe(ends) != 0)
+				throw std::string("Error: BatchDriver can't create a config pipe! ");
+			readEnd_ = ends[0];
+			writeEnd_ = ends[1];
+			name_ = "/dev/fd/" + uint2str((uint) readEnd_);
+#endif
+			writer_ = std::thread(&ConfigPipe::write, this);
+		}
+
+		~ConfigPipe()
+		{
+#ifdef _WIN32
+			// a State that never opened the pipe leaves the writer waiting for it: connect and hang up to release it
+			HANDLE client = CreateFileA(name_.c_str(), GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+			if(client != INVALID_HANDLE_VALUE)
+				CloseHandle(client);
+#else
+			// an unread config makes the writer fail with EPIPE (SIGPIPE must be ignored)
+			close(readEnd_);
+#endif
+			writer_.join();
+		}
+
+		std::string name()
+		{	return name_;	}
+
+protected:
+		std::string config_;
+		std::string name_;
+		std::thread writer_;
+#ifdef _WIN32
+		HANDLE pipe_;
+
+		void write()
+		{
+			if(ConnectNamedPipe(pipe_, NULL) || GetLastError() == ERROR_PIPE_CONNECTED) {
+				DWORD written;
+				WriteFile(pipe_, config_.c_str(), (DWORD) config_.size(), &written, NULL);
+				FlushFileBuffers(pipe_);
+			}
+			CloseHandle(pipe_);
+		}
+#else
+		int readEnd_;
+		int writeEnd_;
+
+		void write()
+		{
+			const char *data = config_.c_str();
+			size_t left = config_.size();
+			while(left > 0) {
+				ssize_t written = ::write(writeEnd_, data, left);
+				if(written < 0 && errno == EINTR)
+					continue;
+				if(written <= 0)
+					break;
+				data += written;
+				left -= written;
+			}
+			close(writeEnd_);
+		}
+#endif
+};
+
+
+/**
+ * \brief Batch driver: optimizes COCO functions 1-24, batch.repeats times each, on all cores
+ *
+ * The (function, repeat) pairs are split into jobs executed on a WorkStealingPool; a job is a chunk of
+ * consecutive repeats of one function (-chunk K, default 5).
+ * A job runs in its own child process (the same executable, started with '-child'), because
+ * the COCO evaluation code and ECF's default randomizer keep their state in process globals;
+ * a chunk of repeats shares that process, so the process start and COCO's setup are paid once per chunk.
+ * Inside a job, every repeat runs in its own State (with batch.repeats = 1 and its own log file),
+ * so the driver, not ECF's batch loop, tells every run which repeat it is. ECF writes batch.statsfile only from
+ * that batch loop, so the driver drops the entry from the runs' config and writes every run's stats file itself:
+ * a header and one line with the fitness of the final population, the evaluations, generations and seconds of the run. ECF builds the deme, individuals, genotypes and
+ * operators of every State itself, so they are not carried over from one repeat to the next: only the process is shared,
+ * and the algorithms reuse their buffers across the generations of a run.
+ * Every repeat draws from its own PhiloxRandomizer stream, keyed by (base seed, config hash, function, repeat),
+ * where the repeat is the philox.repeat entry the driver sets for that run;
+ * the base seed is randomizer.seed, or the current time if it is 0 (it is printed, so a sweep can be replayed).
+ * Results therefore don't depend on the number of threads or the chunk size, and '-job F R'
+ * reruns just repeat R of function F, reproducing that run of the full sweep; its results stay in logFF_rRR.txt and
+ * statsFF_rRR.txt, so the merged files of the sweep are left alone.
+ * When the last chunk of a function finishes, its per-repeat logs and stats are merged, in repeat order,
+ * into the same logNN.txt and statsNN.txt files a sequential batch run produced: the runs in the stats file are
+ * numbered by their repeat in the sweep, and a merged file replaces the previous one only once it is complete.
+ * After every run, the job appends the run's counters (e.g. evaluations skipped by the cache, see RunCounters.h)
+ * to its stats file; with -DECF_PROFILE_PHASES it appends its phase totals as well and writes its per-generation timings
+ * to phasesNN.txt (see PhaseProfiler.h).
+ * With -DECF_TRACE every job writes its timeline to a part file, and the parent merges them with the timeline
+ * of its own workers into trace.json (see TraceSink.h).
+ *
+ * The config file is parsed once, in the parent; each job's registry overrides are applied in memory
+ * (see ConfigTemplate) and the resulting config is piped to the child's stdin (the child's config file argument is '-').
+ * The child adds the overrides of each repeat the same way and hands the State its config through a ConfigPipe.
+ * No config file is ever written.
+ *
+ * usage: program config.txt [-threads N] [-chunk K] [-job F R]
+ */
+class BatchDriver
+{
+public:
+		typedef StateP (*StateFactory)();
+
+		BatchDriver(int argc, char **argv)
+		{
+			if(argc < 2)
+				throw std::string("Error: BatchDriver requires a configuration file! ");
+
+			argv_ = argv;
+			configFile_ = argv[1];
+			firstFunction_ = 1;
+			lastFunction_ = 24;
+			nThreads_ = std::thread::hardware_concurrency();
+			chunk_ = 5;
+			firstRepeat_ = 1;
+			lastRepeat_ = 0;
+			isSingleJob_ = false;
+			isChild_ = false;
+
+			for(int i = 2; i < argc; i++) {
+				std::string arg = argv[i];
+				if(arg == "-threads" && i + 1 < argc)
+					nThreads_ = str2uint(argv[++i]);
+				else if(arg == "-chunk" && i + 1 < argc)
+					chunk_ = str2uint(argv[++i]);
+				else if(arg == "-job" && i + 2 < argc) {
+					firstFunction_ = lastFunction_ = str2uint(argv[++i]);
+					firstRepeat_ = lastRepeat_ = str2uint(argv[++i]);
+					isSingleJob_ = true;
+					if(firstFunction_ < 1 || firstFunction_ > 24)
+						throw std::string("Error: -job F R requires a COCO function F in 1-24! ");
+					if(firstRepeat_ < 1)
+						throw std::string("Error: -job F R requires a repeat R of at least 1! ");
+				}
+				else if(arg == "-child")
+					isChild_ = true;
+				else if(arg == "-trace" && i + 1 < argc)
+					traceFile_ = argv[++i];
+			}
+			if(nThreads_ < 1)
+				nThreads_ = 1;
+		}
+
+		int run(StateFactory createState)
+		{
+			if(isChild_)
+				return runJob(createState);
+			return runBatch();
+		}
+
+protected:
+		char **argv_;
+		std::string configFile_;
+		uint firstFunction_;
+		uint lastFunction_;
+		uint nThreads_;
+		uint repeats_;
+		uint firstRepeat_;
+		uint lastRepeat_;
+		uint chunk_;
+		uint baseSeed_;
+		uint configHash_;
+		bool isSingleJob_;		// -job F R: a single repeat, which isn't merged into the sweep's files
+		bool isChild_;
+		std::string traceFile_;		// child: where the job writes its trace events
+
+		static std::string twoDigits(uint number)
+		{
+			return (number < 10 ? "0" : "") + uint2str(number);
+		}
+
+		std::string logName(uint function)
+		{	return "log" + twoDigits(function) + ".txt";	}
+
+		std::string statsName(uint function)
+		{	return "stats" + twoDigits(function) + ".txt";	}
+
+		std::string phasesName(uint function)
+		{	return "phases" + twoDigits(function) + ".txt";	}
+
+		std::string jobName(BatchJob job)
+		{	return twoDigits(job.function) + "_r" + twoDigits(job.repeat);	}
+
+		std::string traceName(BatchJob job)
+		{	return "trace" + jobName(job) + ".json";	}
+
+		// FNV-1a hash, identifies the parameter configuration in the random stream key
+		static uint hashString(const std::string &text)
+		{
+			uint32_t hash = 2166136261u;
+			for(uint i = 0; i < text.size(); i++)
+				hash = (hash ^ (unsigned char) text[i]) * 16777619u;
+			return hash;
+		}
+
+		// registry entries that differ from the config template for a single job
+		// (the job's repeats are told to the child as philox.repeat, the first one, and batch.repeats)
+		RegistryOverrides jobOverrides(BatchJob job)
+		{
+			RegistryOverrides overrides;
+			overrides["coco.function"] = uint2str(job.function);
+			overrides["batch.repeats"] = uint2str(job.nRepeats);
+			overrides["philox.seed"] = uint2str(baseSeed_);
+			overrides["philox.config"] = uint2str(configHash_);
+			overrides["philox.function"] = uint2str(job.function);
+			overrides["philox.repeat"] = uint2str(job.repeat);
+			return overrides;
+		}
+
+		// registry entries the child sets on top of the job's config for a single repeat (run.nRepeats is 1)
+		RegistryOverrides runOverrides(BatchJob run)
+		{
+			RegistryOverrides overrides;
+			overrides["log.filename"] = "log" + jobName(run) + ".txt";
+			overrides["batch.repeats"] = "1";
+			overrides["philox.repeat"] = uint2str(run.repeat);
+			return overrides;
+		}
+
+		// parent process: spread all jobs over the pool
+		int runBatch()
+		{
+			TraceSink::instance().nameThread("main");
+			TraceSink::instance().begin("config");
+			ConfigTemplate config(configFile_);
+
+			repeats_ = str2uint(config.getEntry("batch.repeats", "1"));
+			if(repeats_ < 1)
+				repeats_ = 1;
+			baseSeed_ = str2uint(config.getEntry("randomizer.seed", "0"));
+			if(baseSeed_ == 0)
+				baseSeed_ = (uint) time(NULL);
+			configHash_ = hashString(config.instantiate(RegistryOverrides()));
+
+			if(isSingleJob_ && firstRepeat_ > repeats_)
+				throw std::string("Error: -job F R requires a repeat R in 1-" + uint2str(repeats_) + " (batch.repeats)! ");
+			if(lastRepeat_ == 0 || lastRepeat_ > repeats_)
+				lastRepeat_ = repeats_;
+			uint nRepeats = lastRepeat_ - firstRepeat_ + 1;
+			uint nFunctions = lastFunction_ - firstFunction_ + 1;
+			if(chunk_ < 1)
+				chunk_ = 1;
+			if(chunk_ > nRepeats)
+				chunk_ = nRepeats;
+			uint nChunks = (nRepeats + chunk_ - 1) / chunk_;
+
+			std::vector< std::shared_ptr< std::atomic<uint> > > remaining;
+			for(uint i = 0; i < nFunctions; i++)
+				remaining.push_back(std::make_shared< std::atomic<uint> >(nChunks));
+
+#ifndef _WIN32
+			// a child that dies before reading its config must not take the parent down with it
+			signal(SIGPIPE, SIG_IGN);
+#endif
+			WorkStealingPool pool(nThreads_);
+			std::cout << "BatchDriver: " << nFunctions * nChunks << " jobs of " << chunk_ << " repeats on " << pool.getSize() << " threads";
+			std::cout << ", base seed " << baseSeed_ << std::endl;
+
+			for(uint repeat = firstRepeat_; repeat <= lastRepeat_; repeat += chunk_)
+				for(uint function = firstFunction_; function <= lastFunction_; function++) {
+					BatchJob job = { function, repeat, std::min(chunk_, lastRepeat_ - repeat + 1) };
+					// all job configs are instantiated here, in a single thread
+					std::shared_ptr<std::string> jobConfig = std::make_shared<std::string>(config.instantiate(jobOverrides(job)));
+					std::shared_ptr< std::atomic<uint> > counter = remaining[function - firstFunction_];
+					pool.push([this, job, jobConfig, counter] () {
+						TraceSink::instance().begin("job", "function", job.function, "repeat", job.repeat);
+						launchJob(job, *jobConfig);
+						TraceSink::instance().end("job");
+						// the last finished chunk merges the function's results
+						if(--(*counter) == 0 && !isSingleJob_)
+							mergeResults(job.function);
+					});
+				}
+
+			TraceSink::instance().end("config");
+
+			pool.run();
+			if(isSingleJob_) {
+				BatchJob job = { firstFunction_, firstRepeat_, 1 };
+				std::cout << "BatchDriver: results in log" << jobName(job) << ".txt and stats" << jobName(job) << ".txt" << std::endl;
+			}
+#ifdef ECF_TRACE
+			std::vector<std::string> parts;
+			for(uint repeat = firstRepeat_; repeat <= lastRepeat_; repeat += chunk_)
+				for(uint function = firstFunction_; function <= lastFunction_; function++) {
+					BatchJob job = { function, repeat, 0 };
+					parts.push_back(traceName(job));
+				}
+			TraceSink::instance().setProcessName("BatchDriver");
+			TraceSink::instance().writeTrace("trace.json", parts);
+#endif
+			return 0;
+		}
+
+		// start a job in a child process, hand it its config and wait for it
+		void launchJob(BatchJob job, const std::string &jobConfig)
+		{
+			std::string command = "\"" + std::string(argv_[0]) + "\" - -child" + traceArgument(job);
+#ifdef _WIN32
+			// cmd.exe strips the outer quotes
+			command = "\"" + command + "\"";
+			FILE *child = _popen(command.c_str(), "wb");
+#else
+			FILE *child = popen(command.c_str(), "w");
+#endif
+			int status = -1;
+			if(child != NULL) {
+				fwrite(jobConfig.c_str(), 1, jobConfig.size(), child);
+#ifdef _WIN32
+				status = _pclose(child);
+#else
+				status = pclose(child);
+#endif
+			}
+			if(status != 0)
+				std::cerr << "BatchDriver: job failed (function " << job.function << ", repeat " << job.repeat << ")" << std::endl;
+		}
+
+		// command line argument telling the job where to write its trace
+#ifdef ECF_TRACE
+		std::string traceArgument(BatchJob job)
+		{	return " -trace " + traceName(job);	}
+#else
+		std::string traceArgument(BatchJob)
+		{	return "";	}
+#endif
+
+		// length of the run number a line of an ECF stats file starts with, 0 if it isn't a run
+		static uint runNumberLength(const std::string &line)
+		{
+			uint digits = 0;
+			while(digits < line.size() && line[digits] >= '0' && line[digits] <= '9')
+				digits++;
+			if(digits < line.size() && line[digits] != '\t' && line[digits] != ' ')
+				return 0;
+			return digits;
+		}
+
+		// write a run's stats file: the header and the run's line (minimum, maximum, average and standard deviation
+		// of the final population's fitness, evaluations, generations, seconds); counters are appended after it
+		static void writeRunStats(std::string statsFile, uint run, const std::vector<IndividualP> &individuals,
+			uint evaluations, uint generations, double seconds)
+		{
+			double min = 0, max = 0, sum = 0, sumSquares = 0;
+			for(uint i = 0; i < individuals.size(); i++) {
+				double value = individuals[i]->fitness->getValue();
+				if(i == 0 || value < min)
+					min = value;
+				if(i == 0 || value > max)
+					max = value;
+				sum += value;
+				sumSquares += value * value;
+			}
+			double n = individuals.empty() ? 1 : (double) individuals.size();
+			double average = sum / n;
+			double variance = sumSquares / n - average * average;
+
+			std::ofstream fout(statsFile.c_str());
+			fout.precision(12);
+			fout << "run\tfit_min\tfit_max\tfit_avg\tfit_std\tevaluations\tgenerations\ttime\n";
+			fout << run << "\t" << min << "\t" << max << "\t" << average << "\t" << sqrt(variance > 0 ? variance : 0.)
+				<< "\t" << evaluations << "\t" << generations << "\t" << seconds << "\n";
+		}
+
+		// append the per-repeat files (the first run of parts[i] is repeat firstRepeats[i]) to the per-function file, in repeat order;
+		// with renumber (stats files), runs are numbered by their repeat instead of restarting from 1 in every part,
+		// and the header lines are written only once.
+		// The merged file is written next to the target and replaces it only if every part was there and all of it was written;
+		// then the parts are removed, otherwise they are kept and the target is left as it was
+		void mergeFiles(std::string target, std::vector<std::string> parts, std::vector<uint> firstRepeats, bool renumber)
+		{
+			std::string merged = target + ".merge";
+			std::ofstream fout(merged.c_str());
+			std::vector<std::string> headers;
+			for(uint i = 0; i < parts.size(); i++) {
+				std::ifstream fin(parts[i].c_str());
+				if(!fin) {
+					fout.close();
+					std::remove(merged.c_str());
+					std::cerr << "BatchDriver: " << target << " not written (" << parts[i] << " is missing)" << std::endl;
+					return;
+				}
+				uint run = firstRepeats[i];
+				std::string line;
+				while(std::getline(fin, line)) {
+					if(renumber) {
+						uint digits = runNumberLength(line);
+						if(line.empty())
+							continue;
+						if(digits > 0)
+							line = uint2str(run++) + line.substr(digits);
+						else if(line[0] != '#') {
+							if(std::find(headers.begin(), headers.end(), line) != headers.end())
+								continue;
+							headers.push_back(line);
+						}
+					}
+					fout << line << "\n";
+				}
+			}
+			fout.close();
+
+			if(!fout) {
+				std::remove(merged.c_str());
+				std::cerr << "BatchDriver: " << target << " not written" << std::endl;
+				return;
+			}
+#ifdef _WIN32
+			std::remove(target.c_str());	// rename doesn't replace an existing file on Windows
+#endif
+			if(std::rename(merged.c_str(), target.c_str()) != 0) {
+				std::cerr << "BatchDriver: " << target << " not written (results are in " << merged << ")" << std::endl;
+				return;
+			}
+			for(uint i = 0; i < parts.size(); i++)
+				std::remove(parts[i].c_str());
+		}
+
+		void mergeResults(uint function)
+		{
+			TRACE_SCOPE("mergeResults");
+			std::vector<std::string> logs, stats, phases;
+			std::vector<uint> firstRepeats;
+			for(uint repeat = firstRepeat_; repeat <= lastRepeat_; repeat++) {
+				BatchJob job = { function, repeat, 0 };
+				logs.push_back("log" + jobName(job) + ".txt");
+				stats.push_back("stats" + jobName(job) + ".txt");
+				phases.push_back("phases" + jobName(job) + ".txt");
+				firstRepeats.push_back(repeat);
+			}
+			mergeFiles(logName(function), logs, firstRepeats, false);
+			mergeFiles(statsName(function), stats, firstRepeats, true);
+#ifdef ECF_PROFILE_PHASES
+			mergeFiles(phasesName(function), phases, firstRepeats, false);
+#endif
+		}
+
+		// child process: the job's config is piped to stdin ('-'), or in the file argv[1];
+		// every repeat runs in its own State, which reads its config from a ConfigPipe
+		int runJob(StateFactory createState)
+		{
+#ifndef _WIN32
+			// a State that fails before reading its config must not kill the job with the ConfigPipe writer
+			signal(SIGPIPE, SIG_IGN);
+#endif
+			std::unique_ptr<ConfigTemplate> config;
+			if(configFile_ == "-")
+				config.reset(new ConfigTemplate(std::cin, "(stdin)"));
+			else
+				config.reset(new ConfigTemplate(configFile_));
+			BatchJob job;
+			job.function = str2uint(config->getEntry("philox.function", "1"));
+			job.repeat = str2uint(config->getEntry("philox.repeat", "1"));
+			job.nRepeats = str2uint(config->getEntry("batch.repeats", "1"));
+			config->removeEntry("batch.statsfile");
+
+			TraceSink::instance().nameThread("algorithm");
+#ifdef ECF_TRACE
+			TraceSink::instance().setProcessName("function " + uint2str(job.function) + ", repeats from " + uint2str(job.repeat));
+#endif
+			for(uint repeat = job.repeat; repeat < job.repeat + job.nRepeats; repeat++) {
+				BatchJob run = { job.function, repeat, 1 };
+				StateP state = createState();
+				state->setRandomizer((RandomizerP) new PhiloxRandomizer);
+
+				TraceSink::instance().begin("initialize", "repeat", repeat);
+				{
+					ConfigPipe runConfig(config->instantiate(runOverrides(run)));
+					std::string configName = runConfig.name();
+					char *runArgv[] = { argv_[0], (char*) configName.c_str() };
+					state->initialize(2, runArgv);
+				}
+				TraceSink::instance().end("initialize");
+#ifdef ECF_PROFILE_PHASES
+				// phase timings are reported with the repeat numbers of the sweep
+				PhaseProfiler::instance().setRun(repeat);
+#endif
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				state->run();
+				double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+				TraceSink::instance().begin("stats");
+				std::vector<IndividualP> individuals;
+				PopulationP population = state->getPopulation();
+				for(uint i = 0; i < population->size(); i++)
+					individuals.insert(individuals.end(), population->at(i)->begin(), population->at(i)->end());
+				writeRunStats("stats" + jobName(run) + ".txt", repeat, individuals,
+					state->getEvaluations(), state->getGenerationNo(), seconds);
+				RunCounters::instance().write("stats" + jobName(run) + ".txt", repeat);
+#ifdef ECF_PROFILE_PHASES
+				PhaseProfiler::instance().write("stats" + jobName(run) + ".txt", "phases" + jobName(run) + ".txt");
+#endif
+				TraceSink::instance().end("stats");
+			}
+#ifdef ECF_TRACE
+			if(!traceFile_.empty())
+				TraceSink::instance().writePart(traceFile_);
+#endif
+			return 0;
+		}
+};
+
+#endif // BatchDriver_h
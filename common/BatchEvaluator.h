@@ -0,0 +1,311 @@
+#ifndef BatchEvaluator_h
+#define BatchEvaluator_h
+
+#include <ecf/ECF.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "CloneArena.h"
+#include "EvaluationCache.h"
+#include "PhaseProfiler.h"
+#include "AllocationCounter.h"
+#include "RunCounters.h"
+
+/**
+ * \brief Evaluates a whole vector of individuals at once, optionally spread over several threads
+ *
+ * Every individual in the range gets a new fitness and counts as one evaluation (State::increaseEvaluations),
+ * exactly as if Algorithm::evaluate had been called on each of them in turn, so term.eval sees the same count.
+ * Evaluations are split into contiguous blocks, one per thread; the calling thread evaluates the first block
+ * and the evaluation counter is updated afterwards from the calling thread.
+ * The other blocks go to worker threads started by the first batch that needs them; they wait on a condition variable
+ * between batches and live as long as the BatchEvaluator (the algorithm, i.e. the run), so a batch starts no threads.
+ * More than one thread requires a reentrant evaluation operator: FunctionMinEvalOp (COCO) keeps its state
+ * in globals, so algorithms default to a single thread, which evaluates in place without any workers.
+ *
+ * Clones in a CloneArena are evaluated through carrier individuals (one per thread, with the algorithm's genotypes):
+ * a clone's coordinates are copied into the carrier's FloatingPoint genotype, and the fitness is stored in the arena.
+ *
+ * Only dirty clones are evaluated: a clean clone keeps its fitness. With the cache enabled (enableCache), a dirty clone
+ * is evaluated only if its coordinates are not in the cache: a cached genotype (or a duplicate of another clone in the same batch)
+ * gets the cached fitness. Such clones don't count as evaluations; they are counted separately (getUnchanged, getCacheHits,
+ * since the last resetCounters), and their run totals go to the stats file as the RunCounters 'unchangedClones' and 'cacheHits'.
+ * Every batch is timed as an 'evaluate' phase (with -DECF_PROFILE_PHASES, see PhaseProfiler.h), and traced with
+ * the block of every thread (with -DECF_TRACE, see TraceSink.h).
+ */
+class BatchEvaluator
+{
+public:
+		BatchEvaluator()
+		{
+			nThreads_ = 1;
+			batch_ = 0;
+			nBlocks_ = 0;
+			remaining_ = 0;
+			stop_ = false;
+			resetCounters();
+		}
+
+		~BatchEvaluator()
+		{
+			{
+				std::lock_guard<std::mutex> guard(lock_);
+				stop_ = true;
+			}
+			start_.notify_all();
+			for(uint i = 0; i < workers_.size(); i++)
+				workers_[i].join();
+		}
+
+		void setThreads(uint nThreads)
+		{	nThreads_ = (nThreads < 1) ? 1 : nThreads;	}
+
+		uint getThreads()
+		{	return nThreads_;	}
+
+		// cache the fitness of about entries genotypes of the given dimension (0 disables the cache, not the dirty flags)
+		void enableCache(uint entries, uint dimension)
+		{	cache_.initialize(entries, dimension);	}
+
+		// forget the cached genotypes (the objective has changed)
+		void clearCache()
+		{	cache_.clear();	}
+
+		// clones that were not evaluated because they didn't change (since resetCounters)
+		uint getUnchanged()
+		{	return unchanged_;	}
+
+		// clones that were not evaluated because their genotype was in the cache (since resetCounters)
+		uint getCacheHits()
+		{	return cacheHits_;	}
+
+		void resetCounters()
+		{
+			unchanged_ = 0;
+			cacheHits_ = 0;
+		}
+
+		// evaluate individuals [first, last)
+		void evaluate(StateP state, EvaluateOpP evalOp, std::vector<IndividualP> &individuals, uint first, uint last)
+		{
+			if(last <= first)
+				return;
+			PROFILE_PHASE("evaluate");
+
+			uint size = last - first;
+			uint nThreads = std::min(nThreads_, size);
+
+			if(nThreads == 1)
+				evaluateBlock(evalOp, individuals, first, last);
+			else {
+				batchOp_ = evalOp;
+				batchIndividuals_ = &individuals;
+				batchArena_ = NULL;
+				runBatch(first, last, nThreads);
+			}
+
+			state->getContext()->evaluatedIndividual = individuals[last - 1];
+			for(uint i = first; i < last; i++)
+				state->increaseEvaluations();
+		}
+
+		// evaluate all individuals
+		void evaluate(StateP state, EvaluateOpP evalOp, std::vector<IndividualP> &individuals)
+		{
+			evaluate(state, evalOp, individuals, 0, (uint) individuals.size());
+		}
+
+		// evaluate clones [first, last) of the arena
+		void evaluate(StateP state, EvaluateOpP evalOp, CloneArena &arena, uint first, uint last, std::vector<IndividualP> &carriers)
+		{
+			if(last <= first)
+				return;
+			PROFILE_PHASE("evaluate");
+
+			evaluateChanged(state, evalOp, arena, first, last, carriers);
+		}
+
+protected:
+		uint nThreads_;
+		EvaluationCache cache_;
+		CloneArena pending_;			// the clones that have to be evaluated, parent is their row in the batch
+		std::vector<uint> duplicate_;		// rows of the batch that duplicate a pending clone
+		std::vector<uint> duplicateOf_;		// index of that pending clone
+		uint unchanged_;
+		uint cacheHits_;
+
+		// worker threads and the batch they share (set by the calling thread before the batch starts)
+		std::vector<std::thread> workers_;
+		std::mutex lock_;
+		std::condition_variable start_;		// a new batch (or stop_)
+		std::condition_variable done_;		// the workers finished their blocks
+		uint batch_;			// number of the current batch
+		uint nBlocks_;			// blocks of the current batch
+		uint remaining_;		// blocks of the current batch the workers haven't finished
+		bool stop_;
+		EvaluateOpP batchOp_;
+		std::vector<IndividualP> *batchIndividuals_;	// individuals of the batch, or NULL for clones
+		CloneArena *batchArena_;
+		std::vector<IndividualP> *batchCarriers_;
+		uint batchFirst_, batchLast_, batchBlockSize_;
+
+		// evaluate [first, last) of the batch in nThreads blocks: the first in the calling thread, the others in the workers
+		void runBatch(uint first, uint last, uint nThreads)
+		{
+			while(workers_.size() < nThreads - 1)
+				workers_.push_back(std::thread(&BatchEvaluator::work, this, (uint) workers_.size() + 1, batch_));
+
+			batchFirst_ = first;
+			batchLast_ = last;
+			batchBlockSize_ = (last - first + nThreads - 1) / nThreads;
+			{
+				std::lock_guard<std::mutex> guard(lock_);
+				nBlocks_ = (last - first + batchBlockSize_ - 1) / batchBlockSize_;
+				remaining_ = nBlocks_ - 1;
+				batch_++;
+			}
+			start_.notify_all();
+
+			runBlock(0);
+
+			std::unique_lock<std::mutex> guard(lock_);
+			while(remaining_ > 0)
+				done_.wait(guard);
+		}
+
+		// worker thread: evaluates block number block of every batch after batch seen that has one
+		void work(uint block, uint seen)
+		{
+			TraceSink::instance().nameThread("evaluation");
+			std::unique_lock<std::mutex> guard(lock_);
+			while(true) {
+				while(batch_ == seen && !stop_)
+					start_.wait(guard);
+				if(stop_)
+					return;
+				seen = batch_;
+				if(block >= nBlocks_)
+					continue;
+
+				guard.unlock();
+				runBlock(block);
+				guard.lock();
+				if(--remaining_ == 0)
+					done_.notify_one();
+			}
+		}
+
+		void runBlock(uint block)
+		{
+			uint begin = batchFirst_ + block * batchBlockSize_;
+			uint end = std::min(begin + batchBlockSize_, batchLast_);
+			if(batchIndividuals_ != NULL)
+				evaluateBlock(batchOp_, *batchIndividuals_, begin, end);
+			else
+				evaluateArenaBlock(batchOp_, *batchArena_, begin, end, (*batchCarriers_)[block]);
+		}
+
+		// evaluate the dirty clones of [first, last); with the cache, only those not cached, each distinct genotype once
+		void evaluateChanged(StateP state, EvaluateOpP evalOp, CloneArena &arena, uint first, uint last, std::vector<IndividualP> &carriers)
+		{
+			static const uint unchangedId = RunCounters::instance().counter("unchangedClones");
+			static const uint cacheHitsId = RunCounters::instance().counter("cacheHits");
+			uint unchanged = unchanged_, cacheHits = cacheHits_;
+			pending_.reserve(last - first, arena.getDimension());
+			duplicate_.clear();
+			duplicateOf_.clear();
+
+			for(uint i = first; i < last; i++) {
+				if(!arena.dirty[i]) {
+					unchanged_++;
+					continue;
+				}
+				if(!cache_.isEnabled()) {
+					pending_.add(arena.constRow(i), arena.fitness[i], 0, i);
+					continue;
+				}
+				uint slot = cache_.find(arena.constRow(i));
+				if(slot == EvaluationCache::NONE) {
+					uint j = pending_.add(arena.constRow(i), arena.fitness[i], 0, i);
+					cache_.insert(arena.constRow(i), FitnessP(), j);
+					continue;
+				}
+				cacheHits_++;
+				if(cache_.getFitness(slot)) {
+					arena.fitness[i] = cache_.getFitness(slot);
+					arena.dirty[i] = 0;
+				}
+				else {
+					duplicate_.push_back(i);
+					duplicateOf_.push_back(cache_.getRow(slot));
+				}
+			}
+
+			RunCounters::instance().add(unchangedId, unchanged_ - unchanged);
+			RunCounters::instance().add(cacheHitsId, cacheHits_ - cacheHits);
+
+			if(pending_.size() > 0)
+				evaluateRange(state, evalOp, pending_, 0, pending_.size(), carriers);
+
+			for(uint j = 0; j < pending_.size(); j++) {
+				uint i = pending_.parent[j];
+				arena.fitness[i] = pending_.fitness[j];
+				arena.dirty[i] = 0;
+				if(!cache_.isEnabled())
+					continue;
+				// the reserved slot may have been taken by a later genotype of the batch
+				uint slot = cache_.find(pending_.constRow(j));
+				if(slot != EvaluationCache::NONE && cache_.getRow(slot) == j && !cache_.getFitness(slot))
+					cache_.setFitness(slot, pending_.fitness[j]);
+			}
+			for(uint k = 0; k < duplicate_.size(); k++) {
+				arena.fitness[duplicate_[k]] = pending_.fitness[duplicateOf_[k]];
+				arena.dirty[duplicate_[k]] = 0;
+			}
+		}
+
+		// evaluate all clones [first, last)
+		void evaluateRange(StateP state, EvaluateOpP evalOp, CloneArena &arena, uint first, uint last, std::vector<IndividualP> &carriers)
+		{
+			uint size = last - first;
+			uint nThreads = std::min(std::min(nThreads_, size), (uint) carriers.size());
+			if(nThreads == 1)
+				evaluateArenaBlock(evalOp, arena, first, last, carriers[0]);
+			else {
+				batchOp_ = evalOp;
+				batchIndividuals_ = NULL;
+				batchArena_ = &arena;
+				batchCarriers_ = &carriers;
+				runBatch(first, last, nThreads);
+			}
+
+			state->getContext()->evaluatedIndividual = carriers[0];
+			for(uint i = first; i < last; i++) {
+				arena.dirty[i] = 0;
+				state->increaseEvaluations();
+			}
+		}
+
+		void evaluateArenaBlock(EvaluateOpP evalOp, CloneArena &arena, uint first, uint last, IndividualP carrier)
+		{
+			TraceSink::instance().nameThread("evaluation");
+			TRACE_SCOPE("evaluateBlock");
+			AllocationCounter::Evaluation evaluation;
+			FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (carrier->getGenotype(0));
+			for(uint i = first; i < last; i++) {
+				arena.copyCoordinates(i, &flp->realValue[0]);
+				arena.fitness[i] = evalOp->evaluate(carrier);
+			}
+		}
+
+		void evaluateBlock(EvaluateOpP evalOp, std::vector<IndividualP> &individuals, uint first, uint last)
+		{
+			TraceSink::instance().nameThread("evaluation");
+			TRACE_SCOPE("evaluateBlock");
+			AllocationCounter::Evaluation evaluation;
+			for(uint i = first; i < last; i++)
+				individuals[i]->fitness = evalOp->evaluate(individuals[i]);
+		}
+};
+
+#endif // BatchEvaluator_h
@@ -0,0 +1,249 @@
+#ifndef CloneArena_h
+#define CloneArena_h
+
+#include <ecf/ECF.h>
+#include "FitnessRanking.h"
+
+/**
+ * \brief Clone population stored as a structure of arrays
+ *
+ * Clone coordinates live in one contiguous row-major (clones x dimension) matrix, with parallel
+ * fitness, age, parent and dirty arrays. The arrays only grow: an arena reserved for the largest clone
+ * population of a generation is reused every generation without allocating.
+ * Algorithms copy the antibodies in, work on the rows, and write the survivors back to the deme individuals.
+ *
+ * Rows are copy-on-write: an antibody added from the deme is copied once into a separate parent matrix,
+ * which is never written, and its row and the rows of all its clones only refer to that copy.
+ * A row gets its own coordinates on the first write access (row()); constRow() reads without copying,
+ * so clones that are never mutated are never copied. Shared rows stay shared through keep().
+ */
+class CloneArena
+{
+public:
+		std::vector<double> values;		// size() rows of dimension coordinates (not up to date for shared rows, see constRow)
+		std::vector<FitnessP> fitness;
+		std::vector<double> age;
+		std::vector<uint> parent;		// rank of the antibody the clone came from, as passed to add() (not its deme index)
+		std::vector<char> dirty;		// the coordinates changed since the fitness was computed
+
+		enum { NONE = 0xFFFFFFFFu };	// the row holds its own coordinates
+
+		CloneArena()
+		{
+			dimension_ = 0;
+			size_ = 0;
+			nParents_ = 0;
+		}
+
+		// make room for capacity clones (the arena is emptied)
+		void reserve(uint capacity, uint dimension)
+		{
+			dimension_ = dimension;
+			size_ = 0;
+			nParents_ = 0;
+			if(capacity > fitness.size() || capacity * dimension > values.size())
+				grow(std::max(capacity, (uint) fitness.size()));
+		}
+
+		uint size()
+		{	return size_;	}
+
+		uint getDimension()
+		{	return dimension_;	}
+
+		void clear()
+		{
+			size_ = 0;
+			nParents_ = 0;
+		}
+
+		// coordinates of clone i, for writing (a shared row gets its own copy first)
+		double* row(uint i)
+		{
+			if(shared_[i] != NONE) {
+				const double *source = &parentValues_[shared_[i] * dimension_];
+				copyRow(source, &values[i * dimension_]);
+				shared_[i] = NONE;
+			}
+			return &values[i * dimension_];
+		}
+
+		// coordinates of clone i, for reading
+		const double* constRow(uint i)
+		{
+			if(shared_[i] != NONE)
+				return &parentValues_[shared_[i] * dimension_];
+			return &values[i * dimension_];
+		}
+
+		// does clone i share its coordinates
+		bool isShared(uint i)
+		{	return shared_[i] != NONE;	}
+
+		// append a clone, return its row index
+		uint add(const double *coordinates, FitnessP cloneFitness, double cloneAge, uint cloneParent)
+		{
+			if(size_ == fitness.size())
+				grow(2 * size_ + 1);
+
+			uint i = size_++;
+			copyRow(coordinates, &values[i * dimension_]);
+			shared_[i] = NONE;
+			fitness[i] = cloneFitness;
+			age[i] = cloneAge;
+			parent[i] = cloneParent;
+			dirty[i] = !cloneFitness;
+			return i;
+		}
+
+		// append a duplicate of clone i (sharing its coordinates if clone i shares them), return its row index
+		uint clone(uint i)
+		{
+			if(size_ == fitness.size())
+				grow(2 * size_ + 1);
+
+			uint j = size_++;
+			shared_[j] = shared_[i];
+			if(shared_[i] == NONE)
+				copyRow(&values[i * dimension_], &values[j * dimension_]);
+			fitness[j] = fitness[i];
+			age[j] = age[i];
+			parent[j] = parent[i];
+			dirty[j] = dirty[i];
+			return j;
+		}
+
+		// overwrite clone i with clone j of another arena (of the same dimension)
+		void set(uint i, CloneArena &from, uint j)
+		{
+			copyRow(from.constRow(j), &values[i * dimension_]);
+			shared_[i] = NONE;
+			fitness[i] = from.fitness[j];
+			age[i] = from.age[j];
+			parent[i] = from.parent[j];
+			dirty[i] = from.dirty[j];
+		}
+
+		// append a copy of clone j of another arena (of the same dimension), return its row index
+		uint add(CloneArena &from, uint j)
+		{
+			uint i = add(from.constRow(j), from.fitness[j], from.age[j], from.parent[j]);
+			dirty[i] = from.dirty[j];
+			return i;
+		}
+
+		// append the antibody's FloatingPoint coordinates (genotype 0), copied into the parent matrix and shared by the row
+		uint add(IndividualP antibody, double cloneAge, uint cloneParent)
+		{
+			FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (antibody->getGenotype(0));
+			if((nParents_ + 1) * dimension_ > parentValues_.size())
+				parentValues_.resize(2 * (nParents_ + 1) * dimension_);
+			std::copy(flp->realValue.begin(), flp->realValue.end(), &parentValues_[nParents_ * dimension_]);
+
+			if(size_ == fitness.size())
+				grow(2 * size_ + 1);
+
+			uint i = size_++;
+			shared_[i] = nParents_++;
+			fitness[i] = antibody->fitness;
+			age[i] = cloneAge;
+			parent[i] = cloneParent;
+			dirty[i] = !antibody->fitness;
+			return i;
+		}
+
+		// copy clone i into the antibody's FloatingPoint genotype and fitness
+		void copyTo(uint i, IndividualP antibody)
+		{
+			FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (antibody->getGenotype(0));
+			flp->realValue.resize(dimension_);
+			copyRow(constRow(i), &flp->realValue[0]);
+			antibody->fitness = fitness[i];
+		}
+
+		// copy the coordinates of clone i to destination (e.g. a carrier's genotype)
+		void copyCoordinates(uint i, double *destination)
+		{	copyRow(constRow(i), destination);	}
+
+		// keep only the listed rows, in the listed order
+		void keep(const std::vector<uint> &rows)
+		{
+			uint newSize = (uint) rows.size();
+			for(uint i = 0; i < newSize; i++) {
+				uint from = rows[i];
+				scratchShared_[i] = shared_[from];
+				if(shared_[from] == NONE)
+					copyRow(&values[from * dimension_], &scratchValues_[i * dimension_]);
+				scratchFitness_[i] = fitness[from];
+				scratchAge_[i] = age[from];
+				scratchParent_[i] = parent[from];
+				scratchDirty_[i] = dirty[from];
+			}
+
+			values.swap(scratchValues_);
+			fitness.swap(scratchFitness_);
+			age.swap(scratchAge_);
+			parent.swap(scratchParent_);
+			dirty.swap(scratchDirty_);
+			shared_.swap(scratchShared_);
+			size_ = newSize;
+		}
+
+		// keep the first newSize rows
+		void truncate(uint newSize)
+		{
+			if(newSize < size_)
+				size_ = newSize;
+		}
+
+		// keep the best k rows, in no particular order (O(size) instead of a full sort)
+		void selectBest(uint k)
+		{
+			if(k >= size_)
+				return;
+			ranking_.load(fitness, size_);
+			keep(ranking_.selectBest(k));
+		}
+
+		// row index of the best clone
+		uint best()
+		{
+			ranking_.load(fitness, size_);
+			return ranking_.best();
+		}
+
+protected:
+		uint dimension_;
+		uint size_;
+		std::vector<uint> shared_;			// row of the parent matrix a clone shares, or NONE
+		std::vector<double> parentValues_;	// coordinates of the antibodies added from the deme
+		uint nParents_;
+		std::vector<double> scratchValues_;
+		std::vector<FitnessP> scratchFitness_;
+		std::vector<double> scratchAge_;
+		std::vector<uint> scratchParent_;
+		std::vector<char> scratchDirty_;
+		std::vector<uint> scratchShared_;
+		FitnessRanking ranking_;
+
+		void grow(uint capacity)
+		{
+			values.resize(capacity * dimension_);
+			fitness.resize(capacity);
+			age.resize(capacity);
+			parent.resize(capacity);
+			dirty.resize(capacity);
+			shared_.resize(capacity);
+			scratchValues_.resize(capacity * dimension_);
+			scratchFitness_.resize(capacity);
+			scratchAge_.resize(capacity);
+			scratchParent_.resize(capacity);
+			scratchDirty_.resize(capacity);
+			scratchShared_.resize(capacity);
+		}
+
+		void copyRow(const double *source, double *destination)
+		{	std::copy(source, source + dimension_, destination);	}
+};
+
+#endif // CloneArena_h
@@ -0,0 +1,72 @@
+#ifndef CloneHeap_h
+#define CloneHeap_h
+
+#include <ecf/ECF.h>
+#include <algorithm>
+#include "CloneArena.h"
+
+/**
+ * \brief Keeps the best clones of a stream of clone blocks, so the whole clone population is never stored at once
+ *
+ * Clones are offered one at a time with their ranking key (see FitnessRanking, lower is better) and copied into
+ * the kept arena only if they qualify:
+ * push() keeps the capacity best clones seen so far in a bounded max-heap (the worst kept clone on top, replaced
+ * in O(log capacity) by a better one); pushBestOfParent() keeps the best clone of every parent, for streams in which
+ * the clones of a parent come in one contiguous run. Among clones with equal keys the first one offered is kept.
+ */
+class CloneHeap
+{
+public:
+		CloneArena clones;	// the kept clones
+
+		CloneHeap()
+		{	capacity_ = 0;	}
+
+		// forget the kept clones, keep at most capacity clones of the given dimension from now on
+		void reset(uint capacity, uint dimension)
+		{
+			capacity_ = capacity;
+			clones.reserve(capacity, dimension);
+			heap_.clear();
+			keys_.clear();
+		}
+
+		uint size()
+		{	return clones.size();	}
+
+		// keep clone i of the block if it is among the capacity best offered so far
+		void push(CloneArena &block, uint i, double key)
+		{
+			if(clones.size() < capacity_) {
+				heap_.push_back(std::make_pair(key, clones.add(block, i)));
+				std::push_heap(heap_.begin(), heap_.end());
+			}
+			else if(capacity_ > 0 && key < heap_.front().first) {
+				std::pop_heap(heap_.begin(), heap_.end());
+				clones.set(heap_.back().second, block, i);
+				heap_.back().first = key;
+				std::push_heap(heap_.begin(), heap_.end());
+			}
+		}
+
+		// keep clone i of the block if it is the best offered so far of its parent's (contiguous) run
+		void pushBestOfParent(CloneArena &block, uint i, double key)
+		{
+			uint last = clones.size() - 1;
+			if(clones.size() == 0 || clones.parent[last] != block.parent[i]) {
+				clones.add(block, i);
+				keys_.push_back(key);
+			}
+			else if(key < keys_.back()) {
+				clones.set(last, block, i);
+				keys_.back() = key;
+			}
+		}
+
+protected:
+		uint capacity_;
+		std::vector< std::pair<double, uint> > heap_;	// (key, row of the kept clone), worst key on top
+		std::vector<double> keys_;						// keys of the kept clones (pushBestOfParent)
+};
+
+#endif // CloneHeap_h
@@ -0,0 +1,96 @@
+#ifndef ConfigTemplate_h
+#define ConfigTemplate_h
+
+#include <ecf/ECF.h>
+#include <map>
+
+// registry key -> value, applied on top of the config template for a single run
+typedef std::map<std::string, std::string> RegistryOverrides;
+
+/**
+ * \brief ECF XML configuration, read and parsed once, instantiated in memory for every run
+ *
+ * instantiate() applies RegistryOverrides to a deep copy of the parsed config and returns the XML text,
+ * so the template itself and the config file on disk are never modified.
+ * XMLNode reference counting is not thread safe: instantiate all runs from a single thread.
+ */
+class ConfigTemplate
+{
+public:
+		ConfigTemplate(std::string fileName)
+		{
+			std::ifstream fin(fileName.c_str());
+			if (!fin) {
+				throw std::string("Error opening file! ");
+			}
+			parse(fin, fileName);
+			fin.close();
+		}
+
+		// config read from a stream (e.g. piped to stdin)
+		ConfigTemplate(std::istream &in, std::string name)
+		{	parse(in, name);	}
+
+		// value of a registry entry in the template, or defaultValue if the config doesn't define it
+		std::string getEntry(std::string key, std::string defaultValue)
+		{
+			XMLNode registry = xConfig_.getChildNode("Registry");
+			XMLNode entry = registry.getChildNodeWithAttribute("Entry", "key", key.c_str());
+			if(entry.isEmpty() || entry.getText() == NULL)
+				return defaultValue;
+			return entry.getText();
+		}
+
+		// drop a registry entry from the template, so that no instance defines it
+		void removeEntry(std::string key)
+		{
+			XMLNode registry = xConfig_.getChildNode("Registry");
+			XMLNode entry = registry.getChildNodeWithAttribute("Entry", "key", key.c_str());
+			if(!entry.isEmpty())
+				entry.deleteNodeContent();
+		}
+
+		// XML text of the template with the given registry entries replaced (or added)
+		std::string instantiate(const RegistryOverrides &overrides)
+		{
+			XMLNode xConfig = xConfig_.deepCopy();
+			XMLNode registry = xConfig.getChildNode("Registry");
+			if(registry.isEmpty())
+				registry = xConfig.addChild("Registry");
+
+			for(RegistryOverrides::const_iterator it = overrides.begin(); it != overrides.end(); ++it) {
+				XMLNode entry = registry.getChildNodeWithAttribute("Entry", "key", it->first.c_str());
+				if(entry.isEmpty()) {
+					entry = registry.addChild("Entry");
+					entry.addAttribute("key", it->first.c_str());
+					entry.addText(it->second.c_str());
+				}
+				else
+					entry.updateText(it->second.c_str());
+			}
+
+			XMLSTR xmlString = xConfig.createXMLString(true);
+			std::string config = xmlString;
+			freeXMLString(xmlString);
+			return config;
+		}
+
+protected:
+		XMLNode xConfig_;
+
+		void parse(std::istream &in, std::string name)
+		{
+			std::string xmlFile, temp;
+			while (!in.eof()) {
+				getline(in, temp);
+				xmlFile += "\n" + temp;
+			}
+
+			XMLResults results;
+			xConfig_ = XMLNode::parseString(xmlFile.c_str(), "ECF", &results);
+			if(xConfig_.isEmpty())
+				throw std::string("Error parsing config file " + name);
+		}
+};
+
+#endif // ConfigTemplate_h
@@ -0,0 +1,125 @@
+#ifndef EvaluationCache_h
+#define EvaluationCache_h
+
+#include <ecf/ECF.h>
+#include <cstring>
+
+/**
+ * \brief Small cache of recently evaluated FloatingPoint genotypes and their fitness
+ *
+ * A direct-mapped hash table: every genotype has a single slot (its hash modulo the power-of-two table size), and
+ * a newer genotype simply replaces whatever was in its slot. A hit requires the coordinates to be bit for bit equal,
+ * so a cached fitness is always the one the evaluation operator returned for exactly these coordinates.
+ * The cache has to be cleared whenever the objective changes (algorithms clear it in initialize()).
+ *
+ * A slot can also be reserved for a genotype that is about to be evaluated (an empty fitness and its arena row),
+ * so duplicates within the same batch are evaluated only once.
+ */
+class EvaluationCache
+{
+public:
+		enum { NONE = 0xFFFFFFFFu };	// no slot
+
+		EvaluationCache()
+		{
+			dimension_ = 0;
+			mask_ = 0;
+		}
+
+		// room for about entries genotypes of the given dimension, all slots empty (0 entries disable the cache)
+		void initialize(uint entries, uint dimension)
+		{
+			dimension_ = dimension;
+			uint slots = 1;
+			while(slots < entries)
+				slots *= 2;
+			if(entries == 0)
+				slots = 0;
+			mask_ = slots - 1;
+			keys_.assign(slots * dimension, 0.);
+			hash_.assign(slots, 0);
+			row_.assign(slots, NONE);
+			fitness_.assign(slots, FitnessP());
+			used_.assign(slots, 0);
+		}
+
+		bool isEnabled()
+		{	return !used_.empty();	}
+
+		// forget all entries
+		void clear()
+		{
+			std::fill(used_.begin(), used_.end(), 0);
+			std::fill(fitness_.begin(), fitness_.end(), FitnessP());
+		}
+
+		// slot holding these coordinates, or NONE
+		uint find(const double *coordinates)
+		{
+			uint64_t h = hash(coordinates);
+			uint slot = (uint) h & mask_;
+			if(!used_[slot] || hash_[slot] != h)
+				return NONE;
+			// are the keys bit for bit equal
+			if(std::memcmp(&keys_[slot * dimension_], coordinates, dimension_ * sizeof(double)) != 0)
+				return NONE;
+			return slot;
+		}
+
+		// store the coordinates with their fitness (empty if it is still being evaluated, in arena row), return the slot
+		uint insert(const double *coordinates, FitnessP fitness, uint row)
+		{
+			uint64_t h = hash(coordinates);
+			uint slot = (uint) h & mask_;
+			std::copy(coordinates, coordinates + dimension_, &keys_[slot * dimension_]);
+			hash_[slot] = h;
+			fitness_[slot] = fitness;
+			row_[slot] = row;
+			used_[slot] = 1;
+			return slot;
+		}
+
+		FitnessP getFitness(uint slot)
+		{	return fitness_[slot];	}
+
+		void setFitness(uint slot, FitnessP fitness)
+		{	fitness_[slot] = fitness;	}
+
+		// arena row that is evaluating the genotype of the slot
+		uint getRow(uint slot)
+		{	return row_[slot];	}
+
+protected:
+		uint dimension_;
+		uint mask_;
+		std::vector<double> keys_;		// coordinates of every slot
+		std::vector<uint64_t> hash_;
+		std::vector<uint> row_;
+		std::vector<FitnessP> fitness_;
+		std::vector<char> used_;
+
+		// hash of the bits of the coordinates (+0.0 and -0.0 differ, as they do for memcmp);
+		// every coordinate goes through a 64 bit finalizer first, since the low mantissa bits of doubles are often all 0
+		uint64_t hash(const double *coordinates)
+		{
+			uint64_t h = 14695981039346656037ULL;
+			for(uint i = 0; i < dimension_; i++) {
+				uint64_t bits;
+				std::memcpy(&bits, coordinates + i, sizeof(bits));
+				h = (h ^ mix(bits)) * 1099511628211ULL;
+			}
+			return mix(h);
+		}
+
+		// MurmurHash3 64 bit finalizer
+		static uint64_t mix(uint64_t x)
+		{
+			x ^= x >> 33;
+			x *= 0xff51afd7ed558ccdULL;
+			x ^= x >> 33;
+			x *= 0xc4ceb9fe1a85ec53ULL;
+			return x ^ (x >> 33);
+		}
+};
+
+#endif // EvaluationCache_h
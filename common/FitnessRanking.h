@@ -0,0 +1,166 @@
+#ifndef FitnessRanking_h
+#define FitnessRanking_h
+
+#include <ecf/ECF.h>
+#include <stdint.h>
+#include <cstring>
+
+/**
+ * \brief Ranks individuals by cached scalar fitness keys
+ *
+ * load() reads every fitness value once into a packed key array, with the direction folded in
+ * (key = value for minimization, -value for FitnessMax), so a smaller key is always better and
+ * ranking compares plain doubles instead of calling the virtual isBetterThan through two shared pointers.
+ * Rankings are index permutations into the loaded range, best first; large full rankings are
+ * radix sorted on the IEEE 754 bit patterns of the keys, small ones use an index sort.
+ */
+class FitnessRanking
+{
+public:
+		// number of keys from which a full ranking uses the radix sort
+		static const uint RADIX_THRESHOLD = 512;
+
+		// load fitness keys of individuals [0, size)
+		void load(const std::vector<IndividualP> &individuals)
+		{
+			uint size = (uint) individuals.size();
+			keys_.resize(size);
+			if(size == 0)
+				return;
+			double direction = getDirection(individuals[0]->fitness);
+			for(uint i = 0; i < size; i++)
+				keys_[i] = direction * individuals[i]->fitness->getValue();
+		}
+
+		// load fitness keys [0, size)
+		void load(const std::vector<FitnessP> &fitness, uint size)
+		{
+			keys_.resize(size);
+			if(size == 0)
+				return;
+			double direction = getDirection(fitness[0]);
+			for(uint i = 0; i < size; i++)
+				keys_[i] = direction * fitness[i]->getValue();
+		}
+
+		uint size()
+		{	return (uint) keys_.size();	}
+
+		// key of the i-th loaded fitness (smaller is better)
+		double key(uint i)
+		{	return keys_[i];	}
+
+		// index of the best loaded fitness
+		uint best()
+		{
+			uint bestIndex = 0;
+			for(uint i = 1; i < keys_.size(); i++)
+				if(keys_[i] < keys_[bestIndex])
+					bestIndex = i;
+			return bestIndex;
+		}
+
+		// all indices, from the best to the worst
+		const std::vector<uint>& rank()
+		{
+			resetOrder();
+			if(order_.size() >= RADIX_THRESHOLD)
+				radixSort();
+			else
+				std::sort(order_.begin(), order_.end(), LowerKey(keys_));
+			return order_;
+		}
+
+		// the k best indices, from the best to the worst
+		const std::vector<uint>& rankBest(uint k)
+		{
+			if(k >= keys_.size())
+				return rank();
+			resetOrder();
+			std::partial_sort(order_.begin(), order_.begin() + k, order_.end(), LowerKey(keys_));
+			order_.resize(k);
+			return order_;
+		}
+
+		// the k best indices, in no particular order
+		const std::vector<uint>& selectBest(uint k)
+		{
+			resetOrder();
+			if(k < order_.size()) {
+				std::nth_element(order_.begin(), order_.begin() + k, order_.end(), LowerKey(keys_));
+				order_.resize(k);
+			}
+			return order_;
+		}
+
+		// +1 if a lower fitness value is better, -1 if a higher one is (FitnessMax)
+		static double getDirection(FitnessP fitness)
+		{
+			return boost::dynamic_pointer_cast<FitnessMax> (fitness) ? -1. : 1.;
+		}
+
+protected:
+		std::vector<double> keys_;
+		std::vector<uint> order_;
+		std::vector<uint> scratchOrder_;
+		std::vector<uint64_t> bits_;
+		std::vector<uint64_t> scratchBits_;
+
+		struct LowerKey
+		{
+			const std::vector<double> &keys;
+			LowerKey(const std::vector<double> &k) : keys(k) {}
+			bool operator() (uint a, uint b) const
+			{	return keys[a] < keys[b];	}
+		};
+
+		void resetOrder()
+		{
+			order_.resize(keys_.size());
+			for(uint i = 0; i < order_.size(); i++)
+				order_[i] = i;
+		}
+
+		// IEEE 754 bits of the key, mapped so that unsigned order is the order of the doubles
+		static uint64_t orderedBits(double key)
+		{
+			uint64_t bits;
+			std::memcpy(&bits, &key, sizeof(bits));
+			return (bits >> 63) ? ~bits : (bits | ((uint64_t) 1 << 63));
+		}
+
+		// LSD radix sort of order_ by key bits, 8 bits per pass; passes where all keys share the digit are skipped
+		void radixSort()
+		{
+			uint size = (uint) order_.size();
+			bits_.resize(size);
+			scratchBits_.resize(size);
+			scratchOrder_.resize(size);
+			for(uint i = 0; i < size; i++)
+				bits_[i] = orderedBits(keys_[i]);
+
+			for(uint shift = 0; shift < 64; shift += 8) {
+				uint count[256] = { 0 };
+				for(uint i = 0; i < size; i++)
+					count[(bits_[i] >> shift) & 0xFF]++;
+				if(count[(bits_[0] >> shift) & 0xFF] == size)
+					continue;
+
+				uint position = 0;
+				for(uint digit = 0; digit < 256; digit++) {
+					uint n = count[digit];
+					count[digit] = position;
+					position += n;
+				}
+				for(uint i = 0; i < size; i++) {
+					uint j = count[(bits_[i] >> shift) & 0xFF]++;
+					scratchBits_[j] = bits_[i];
+					scratchOrder_[j] = order_[i];
+				}
+				bits_.swap(scratchBits_);
+				order_.swap(scratchOrder_);
+			}
+		}
+};
+
+#endif // FitnessRanking_h
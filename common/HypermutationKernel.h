@@ -0,0 +1,159 @@
+#ifndef HypermutationKernel_h
+#define HypermutationKernel_h
+
+#include <ecf/ECF.h>
+#include <cmath>
+#include "PhiloxRandomizer.h"
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+/**
+ * \brief Hypermutation of all clones of a generation in bulk (CLONALG, opt-IA)
+ *
+ * A mutation moves a random coordinate by (1-2*r1) * 0.2 * (ubound-lbound) * 2^(-16*r2) and clamps it to [lbound, ubound].
+ * plan() draws the coordinates and steps of all mutations of a generation at once, in the order the scalar mutation loop
+ * drew them (coordinate, r1, r2 for every mutation): a PhiloxRandomizer hands out the random words in blocks (see fillWords),
+ * any other randomizer is called one number at a time. apply() then moves the coordinates of a single clone,
+ * clamping without branches.
+ *
+ * In exact mode (the default) 2^x is computed with std::pow, so the mutated clones are bit for bit those of the scalar loop.
+ * Otherwise 2^x is computed 8 (AVX-512) or 4 (AVX2) at a time with a polynomial (relative error below 1e-15);
+ * without AVX2 the exact path is used anyway. SIMD code is compiled in with -mavx2 / -mavx512f (e.g. -march=native).
+ */
+class HypermutationKernel
+{
+public:
+		HypermutationKernel()
+		{	exact_ = true;	}
+
+		void setExact(bool exact)
+		{	exact_ = exact;	}
+
+		// draw nMutations mutations of clones with dimension coordinates in [lbound, ubound]
+		void plan(StateP state, uint nMutations, uint dimension, double lbound, double ubound)
+		{
+			coordinate_.resize(nMutations);
+			exponent_.resize(nMutations);
+			step_.resize(nMutations);
+
+			double range = ubound - lbound;
+			PhiloxRandomizer *philox = dynamic_cast<PhiloxRandomizer*> (state->getRandomizer().get());
+			if(philox != NULL && nMutations > 0) {
+				words_.resize(5 * nMutations);
+				philox->fillWords(&words_[0], 5 * nMutations);
+				for(uint j = 0; j < nMutations; j++) {
+					const uint32_t *w = &words_[5 * j];
+					coordinate_[j] = PhiloxRandomizer::toInteger(w[0], (int) dimension);
+					double randDouble1 = PhiloxRandomizer::toDouble(w[1], w[2]);
+					double randDouble2 = PhiloxRandomizer::toDouble(w[3], w[4]);
+					step_[j] = (1-2*randDouble1)* 0.2 * range;
+					exponent_[j] = -16*randDouble2;
+				}
+			}
+			else {
+				for(uint j = 0; j < nMutations; j++) {
+					coordinate_[j] = state->getRandomizer()->getRandomInteger((int) dimension);
+					double randDouble1 = state->getRandomizer()->getRandomDouble();
+					double randDouble2 = state->getRandomizer()->getRandomDouble();
+					step_[j] = (1-2*randDouble1)* 0.2 * range;
+					exponent_[j] = -16*randDouble2;
+				}
+			}
+
+			if(exact_ || !HAS_SIMD_EXP2) {
+				for(uint j = 0; j < nMutations; j++)
+					step_[j] = step_[j] * pow(2, exponent_[j]);
+			}
+			else
+				scaleByExp2(&step_[0], &exponent_[0], nMutations);
+		}
+
+		// apply planned mutations [first, last) to a clone's coordinates;
+		// returns whether any coordinate changed (mutations clamped at the bound it is already on don't)
+		bool apply(double *coordinates, uint first, uint last, double lbound, double ubound)
+		{
+			bool changed = false;
+			for(uint j = first; j < last; j++) {
+				uint param = coordinate_[j];
+				double value = std::min(std::max(coordinates[param] + step_[j], lbound), ubound);
+				changed |= (value != coordinates[param]);
+				coordinates[param] = value;
+			}
+			return changed;
+		}
+
+protected:
+		bool exact_;
+		std::vector<uint32_t> words_;
+		std::vector<uint> coordinate_;
+		std::vector<double> exponent_;
+		std::vector<double> step_;
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+		enum { HAS_SIMD_EXP2 = 1 };
+#else
+		enum { HAS_SIMD_EXP2 = 0 };
+#endif
+
+		// 2^f for |f| <= 1/2: Taylor polynomial of exp(t), t = f*ln2, of degree 12 (Horner, coefficients 1/k!)
+		static double exp2Fraction(double f)
+		{
+			double t = f * 0.69314718055994530942;
+			double p = 1. / 479001600;
+			p = p * t + 1. / 39916800;
+			p = p * t + 1. / 3628800;
+			p = p * t + 1. / 362880;
+			p = p * t + 1. / 40320;
+			p = p * t + 1. / 5040;
+			p = p * t + 1. / 720;
+			p = p * t + 1. / 120;
+			p = p * t + 1. / 24;
+			p = p * t + 1. / 6;
+			p = p * t + 1. / 2;
+			p = p * t + 1.;
+			return p * t + 1.;
+		}
+
+		// step[j] *= 2^exponent[j], vectorized (the tail uses the same polynomial in scalar code)
+		static void scaleByExp2(double *step, const double *exponent, uint n)
+		{
+			uint j = 0;
+#if defined(__AVX512F__)
+			for(; j + 8 <= n; j += 8) {
+				__m512d x = _mm512_loadu_pd(exponent + j);
+				__m512d k = _mm512_roundscale_pd(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+				__m512d t = _mm512_mul_pd(_mm512_sub_pd(x, k), _mm512_set1_pd(0.69314718055994530942));
+				__m512d p = _mm512_set1_pd(1. / 479001600);
+				const double c[12] = { 1. / 39916800, 1. / 3628800, 1. / 362880, 1. / 40320, 1. / 5040, 1. / 720,
+					1. / 120, 1. / 24, 1. / 6, 1. / 2, 1., 1. };
+				for(uint i = 0; i < 12; i++)
+					p = _mm512_add_pd(_mm512_mul_pd(p, t), _mm512_set1_pd(c[i]));
+				p = _mm512_scalef_pd(p, k);
+				_mm512_storeu_pd(step + j, _mm512_mul_pd(_mm512_loadu_pd(step + j), p));
+			}
+#endif
+#if defined(__AVX2__)
+			for(; j + 4 <= n; j += 4) {
+				__m256d x = _mm256_loadu_pd(exponent + j);
+				__m256d k = _mm256_round_pd(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+				__m256d t = _mm256_mul_pd(_mm256_sub_pd(x, k), _mm256_set1_pd(0.69314718055994530942));
+				__m256d p = _mm256_set1_pd(1. / 479001600);
+				const double c[12] = { 1. / 39916800, 1. / 3628800, 1. / 362880, 1. / 40320, 1. / 5040, 1. / 720,
+					1. / 120, 1. / 24, 1. / 6, 1. / 2, 1., 1. };
+				for(uint i = 0; i < 12; i++)
+					p = _mm256_add_pd(_mm256_mul_pd(p, t), _mm256_set1_pd(c[i]));
+				// 2^k, k integer in [-16, 0]: built in the exponent bits
+				__m256i e = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(k));
+				__m256d scale = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(e, _mm256_set1_epi64x(1023)), 52));
+				_mm256_storeu_pd(step + j, _mm256_mul_pd(_mm256_loadu_pd(step + j), _mm256_mul_pd(p, scale)));
+			}
+#endif
+			for(; j < n; j++) {
+				double k = nearbyint(exponent[j]);
+				step[j] = step[j] * ldexp(exp2Fraction(exponent[j] - k), (int) k);
+			}
+		}
+};
+
+#endif // HypermutationKernel_h
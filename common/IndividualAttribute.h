@@ -0,0 +1,47 @@
+#ifndef IndividualAttribute_h
+#define IndividualAttribute_h
+
+#include <ecf/ECF.h>
+
+/**
+ * \brief Typed per-individual bookkeeping of an algorithm (trial counter, age...), kept outside the genotypes
+ *
+ * Values are stored in one flat array per deme, indexed by Individual::index, i.e. by the individual's slot in its deme.
+ * copy() keeps the index and Deme::replace() gives the new individual the slot's index, so the value belongs to the slot:
+ * an individual that replaces another takes over its value, unless the algorithm resets it.
+ * The values are not genotypes, so they are not initialized randomly, mutated, written to milestones or logged.
+ * Algorithms call clear() in initialize(): every run (e.g. the next run of an ECF batch) starts from the initial value.
+ */
+template <class T>
+class IndividualAttribute
+{
+public:
+		explicit IndividualAttribute(T initialValue = T())
+		{	initialValue_ = initialValue;	}
+
+		// forget the values of all demes
+		void clear()
+		{
+			demes_.clear();
+			values_.clear();
+		}
+
+		// values of the deme's individuals (created with the initial value on first use), indexed by Individual::index
+		std::vector<T>& of(DemeP deme)
+		{
+			for(uint i = 0; i < demes_.size(); i++)
+				if(demes_[i] == deme.get())
+					return values_[i];
+
+			demes_.push_back(deme.get());
+			values_.push_back(std::vector<T>(deme->getSize(), initialValue_));
+			return values_.back();
+		}
+
+protected:
+		T initialValue_;
+		std::vector<Deme*> demes_;
+		std::vector< std::vector<T> > values_;
+};
+
+#endif // IndividualAttribute_h
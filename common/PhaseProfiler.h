@@ -0,0 +1,297 @@
+#ifndef PhaseProfiler_h
+#define PhaseProfiler_h
+
+#include <ecf/ECF.h>
+#include "TraceSink.h"
+#ifdef ECF_PROFILE_PHASES
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#if defined(ECF_PROFILE_COUNTERS) && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+/**
+ * \brief Time spent in each phase of advanceGeneration (and in evaluation calls), totalled per generation and per run
+ *
+ * Compiled in only with -DECF_PROFILE_PHASES: without it PROFILE_PHASE doesn't time anything (it only traces, with -DECF_TRACE,
+ * and expands to nothing otherwise) and the PhaseProfiler calls are empty.
+ * PROFILE_PHASE("name") times the rest of the enclosing scope (and traces it, see TraceSink.h). Phases nest (hypermutationPhase contains its evaluation calls),
+ * so their times are inclusive; the 'generation' entry is the wall time from the end of one generation to the end of the next.
+ * With -DECF_PROFILE_COUNTERS as well (Linux only), every phase also counts CPU cycles, instructions and cache misses
+ * with perf_event_open; if the kernel refuses (see /proc/sys/kernel/perf_event_paranoid) the counts are 0.
+ * The counters follow only the thread that first uses the profiler (the algorithm's thread): the work of BatchEvaluator's
+ * evaluation threads is in the phase times, but not in the counts.
+ * A timed phase costs two clock reads, plus two read() system calls with counters.
+ *
+ * Algorithms call beginRun() in initialize() and endGeneration() at the end of every generation. When the job ends,
+ * BatchDriver appends the totals of every run to the job's stats file, after ECF's fitness statistics, as comment lines
+ *	# phase <run> total <name> <calls> <seconds> <cycles> <instructions> <cache misses>
+ * and writes the same lines for every generation (with the generation number instead of 'total') to a separate
+ * phasesNN.txt file, so the stats file doesn't grow with the number of generations.
+ * Only the algorithm's thread may time phases.
+ */
+#ifdef ECF_PROFILE_PHASES
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_TIMER(name) \
+	static const uint PROFILE_CONCAT(phaseId_, __LINE__) = PhaseProfiler::instance().phase(name); \
+	ScopedPhase PROFILE_CONCAT(phaseTimer_, __LINE__) (PROFILE_CONCAT(phaseId_, __LINE__))
+
+class PhaseProfiler
+{
+public:
+		enum { CYCLES, INSTRUCTIONS, CACHE_MISSES, N_COUNTERS };
+
+		struct Total
+		{
+			uint calls;
+			double seconds;
+			uint64_t counters[N_COUNTERS];
+		};
+
+		static PhaseProfiler& instance()
+		{
+			static PhaseProfiler profiler;
+			return profiler;
+		}
+
+		// id of the named phase (registered on first use)
+		uint phase(const char *name)
+		{
+			for(uint i = 0; i < names_.size(); i++)
+				if(std::strcmp(names_[i], name) == 0)
+					return i;
+			names_.push_back(name);
+			generation_.push_back(Total());
+			run_.push_back(Total());
+			clear(generation_.back());
+			clear(run_.back());
+			return (uint) names_.size() - 1;
+		}
+
+		// current time and counter values
+		void sample(std::chrono::steady_clock::time_point &time, uint64_t *counters)
+		{
+			time = std::chrono::steady_clock::now();
+			readCounters(counters);
+		}
+
+		// add a finished call of phase id, started at the sampled time and counter values
+		void add(uint id, std::chrono::steady_clock::time_point start, const uint64_t *startCounters)
+		{
+			std::chrono::steady_clock::time_point time;
+			uint64_t counters[N_COUNTERS];
+			sample(time, counters);
+			Total &total = generation_[id];
+			total.calls++;
+			total.seconds += std::chrono::duration<double>(time - start).count();
+			for(uint i = 0; i < N_COUNTERS; i++)
+				total.counters[i] += counters[i] - startCounters[i];
+		}
+
+		// repeat number the current run's totals are reported with
+		void setRun(uint run)
+		{	runNumber_ = run;	}
+
+		// a new run starts: the totals of the previous one are reported
+		void beginRun()
+		{
+			endRun();
+			nGenerations_ = 0;
+			sample(generationStart_, generationCounters_);
+		}
+
+		// report the totals of the generation and add them to the run's
+		void endGeneration()
+		{
+			add(phase("generation"), generationStart_, generationCounters_);
+			nGenerations_++;
+			std::string label = uint2str(nGenerations_);
+			for(uint i = 0; i < names_.size(); i++) {
+				if(generation_[i].calls == 0)
+					continue;
+				report(generationReport_, label, i, generation_[i]);
+				run_[i].calls += generation_[i].calls;
+				run_[i].seconds += generation_[i].seconds;
+				for(uint j = 0; j < N_COUNTERS; j++)
+					run_[i].counters[j] += generation_[i].counters[j];
+				clear(generation_[i]);
+			}
+			sample(generationStart_, generationCounters_);
+		}
+
+		// append the run totals reported so far to the stats file, and the generation totals to generationFile
+		void write(std::string statsFile, std::string generationFile)
+		{
+			endRun();
+			append(statsFile, report_);
+			append(generationFile, generationReport_);
+		}
+
+protected:
+		std::vector<const char*> names_;
+		std::vector<Total> generation_;		// totals of the current generation, by phase id
+		std::vector<Total> run_;			// totals of the current run
+		std::ostringstream report_;				// run totals
+		std::ostringstream generationReport_;	// generation totals
+		uint runNumber_;		// repeat number of the current run
+		uint nGenerations_;		// generations of the current run
+		std::chrono::steady_clock::time_point generationStart_;
+		uint64_t generationCounters_[N_COUNTERS];
+		int leader_;			// perf_event group leader, -1 without counters
+		int counterFd_[N_COUNTERS];
+
+		PhaseProfiler()
+		{
+			runNumber_ = 1;
+			nGenerations_ = 0;
+			openCounters();
+			sample(generationStart_, generationCounters_);
+		}
+
+		static void clear(Total &total)
+		{
+			total.calls = 0;
+			total.seconds = 0;
+			for(uint i = 0; i < N_COUNTERS; i++)
+				total.counters[i] = 0;
+		}
+
+		void report(std::ostringstream &out, const std::string &label, uint id, const Total &total)
+		{
+			out << "# phase " << runNumber_ << " " << label << " " << names_[id] << " " << total.calls
+				<< " " << total.seconds;
+			for(uint i = 0; i < N_COUNTERS; i++)
+				out << " " << total.counters[i];
+			out << "\n";
+		}
+
+		static void append(std::string fileName, std::ostringstream &lines)
+		{
+			if(fileName.empty() || lines.str().empty())
+				return;
+			std::ofstream fout(fileName.c_str(), std::ios::app);
+			fout << lines.str();
+			lines.str("");
+		}
+
+		void endRun()
+		{
+			if(nGenerations_ == 0)
+				return;
+			for(uint i = 0; i < names_.size(); i++) {
+				if(run_[i].calls > 0)
+					report(report_, "total", i, run_[i]);
+				clear(run_[i]);
+			}
+			nGenerations_ = 0;
+		}
+
+#if defined(ECF_PROFILE_COUNTERS) && defined(__linux__)
+		// cycles, instructions and cache misses of the calling thread in user space, read as a single group
+		void openCounters()
+		{
+			static const uint64_t config[N_COUNTERS] =
+				{ PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES };
+			leader_ = -1;
+			for(uint i = 0; i < N_COUNTERS; i++) {
+				perf_event_attr attr;
+				std::memset(&attr, 0, sizeof(attr));
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.size = sizeof(attr);
+				attr.config = config[i];
+				attr.disabled = (i == 0);
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_GROUP;
+				counterFd_[i] = (int) syscall(__NR_perf_event_open, &attr, 0, -1, leader_, 0);
+				if(counterFd_[i] < 0) {
+					for(uint j = 0; j < i; j++)
+						close(counterFd_[j]);
+					leader_ = -1;
+					return;
+				}
+				if(i == 0)
+					leader_ = counterFd_[0];
+			}
+			ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+			ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		}
+
+		void readCounters(uint64_t *counters)
+		{
+			uint64_t group[1 + N_COUNTERS];	// number of counters, then their values
+			if(leader_ < 0 || read(leader_, group, sizeof(group)) != (ssize_t) sizeof(group)) {
+				for(uint i = 0; i < N_COUNTERS; i++)
+					counters[i] = 0;
+				return;
+			}
+			for(uint i = 0; i < N_COUNTERS; i++)
+				counters[i] = group[1 + i];
+		}
+#else
+		void openCounters()
+		{	leader_ = -1;	}
+
+		void readCounters(uint64_t *counters)
+		{
+			for(uint i = 0; i < N_COUNTERS; i++)
+				counters[i] = 0;
+		}
+#endif
+};
+
+
+/**
+ * \brief Adds the time (and counters) from its construction to its destruction to a phase of the PhaseProfiler
+ */
+class ScopedPhase
+{
+public:
+		explicit ScopedPhase(uint id)
+		{
+			id_ = id;
+			PhaseProfiler::instance().sample(start_, counters_);
+		}
+
+		~ScopedPhase()
+		{	PhaseProfiler::instance().add(id_, start_, counters_);	}
+
+protected:
+		uint id_;
+		std::chrono::steady_clock::time_point start_;
+		uint64_t counters_[PhaseProfiler::N_COUNTERS];
+};
+
+#else
+
+#define PROFILE_TIMER(name)
+
+class PhaseProfiler
+{
+public:
+		static PhaseProfiler& instance()
+		{
+			static PhaseProfiler profiler;
+			return profiler;
+		}
+
+		void beginRun()
+		{}
+
+		void endGeneration()
+		{}
+};
+
+#endif
+
+#define PROFILE_PHASE(name) PROFILE_TIMER(name); TRACE_SCOPE(name)
+
+#endif // PhaseProfiler_h
@@ -0,0 +1,218 @@
+#ifndef PhiloxRandomizer_h
+#define PhiloxRandomizer_h
+
+#include <ecf/ECF.h>
+#include <stdint.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/**
+ * \brief Counter-based randomizer (Philox4x32-10, Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+ *
+ * The i-th random number of a run is a pure function of (seed, config, function, repeat, i),
+ * so every repeat has its own independent stream, no matter which process or thread runs it or
+ * which repeats ran before it; a single repeat can be replayed alone and gives the same numbers.
+ *
+ * The stream is selected by registry entries the BatchDriver sets for every run:
+ *		- philox.seed: base seed
+ *		- philox.config: hash of the parameter configuration
+ *		- philox.function: COCO function Id
+ *		- philox.repeat: repeat number of the run
+ * Every run has its own State, and BatchDriver sets philox.repeat for it: initialize() only reads the key,
+ * so it gives the same stream however often ECF calls it.
+ *
+ * fillWords() hands out many words at once (4 blocks per step with AVX2), the same words as one by one.
+ */
+class PhiloxRandomizer : public Randomizer
+{
+public:
+		PhiloxRandomizer()
+		{
+			seed_ = config_ = function_ = repeat_ = 0;
+			setStream(0, 0, 0, 0);
+		}
+
+		void registerParameters(StateP state)
+		{
+			state->getRegistry()->registerEntry("philox.seed", (voidP) new uint(0), ECF::UINT, "base seed of the counter based randomizer");
+			state->getRegistry()->registerEntry("philox.config", (voidP) new uint(0), ECF::UINT, "parameter configuration Id (part of the stream key)");
+			state->getRegistry()->registerEntry("philox.function", (voidP) new uint(0), ECF::UINT, "COCO function Id (part of the stream key)");
+			state->getRegistry()->registerEntry("philox.repeat", (voidP) new uint(1), ECF::UINT, "repeat number of the run (part of the stream key)");
+		}
+
+		bool initialize(StateP state)
+		{
+			voidP sptr = state->getRegistry()->getEntry("philox.seed");
+			seed_ = *((uint*) sptr.get());
+			sptr = state->getRegistry()->getEntry("philox.config");
+			config_ = *((uint*) sptr.get());
+			sptr = state->getRegistry()->getEntry("philox.function");
+			function_ = *((uint*) sptr.get());
+			sptr = state->getRegistry()->getEntry("philox.repeat");
+			repeat_ = *((uint*) sptr.get());
+
+			setStream(seed_, config_, function_, repeat_);
+			return true;
+		}
+
+		// select the stream and rewind it to its first number
+		void setStream(uint seed, uint config, uint function, uint repeat)
+		{
+			key_[0] = seed;
+			key_[1] = config;
+			counter_[0] = 0;
+			counter_[1] = 0;
+			counter_[2] = repeat;
+			counter_[3] = function;
+			next_ = 4;
+		}
+
+		// uniform double in [0, 1), 53 random bits
+		double getRandomDouble()
+		{
+			uint32_t a = nextWord();
+			return toDouble(a, nextWord());
+		}
+
+		// uniform integer in [p, q]
+		int getRandomInteger(int p, int q)
+		{
+			return p + getRandomInteger(q - p + 1);
+		}
+
+		// uniform integer in [0, size)
+		int getRandomInteger(int size)
+		{
+			return toInteger(nextWord(), size);
+		}
+
+		// the next n random words, exactly those n calls of nextWord() would give
+		void fillWords(uint32_t *out, uint n)
+		{
+			uint i = 0;
+			// rest of the current block
+			while(i < n && next_ < 4)
+				out[i++] = block_[next_++];
+			// whole blocks
+#ifdef __AVX2__
+			for(; n - i >= 16; i += 16) {
+				philox4x32x4(counter_, key_, out + i);
+				advance(4);
+			}
+#endif
+			for(; n - i >= 4; i += 4) {
+				philox4x32(counter_, key_, out + i);
+				advance(1);
+			}
+			// start of the next block
+			while(i < n)
+				out[i++] = nextWord();
+		}
+
+		// uniform double in [0, 1) from two random words (getRandomDouble)
+		static double toDouble(uint32_t a, uint32_t b)
+		{
+			return ((a >> 5) * 67108864. + (b >> 6)) * (1. / 9007199254740992.);
+		}
+
+		// uniform integer in [0, size) from a random word (getRandomInteger)
+		static int toInteger(uint32_t word, int size)
+		{
+			return (int) (((uint64_t) word * (uint64_t) size) >> 32);
+		}
+
+		// 4 random 32 bit words for the given counter and key
+		static void philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4])
+		{
+			uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+			uint32_t k0 = key[0], k1 = key[1];
+
+			for(uint round = 0; round < 10; round++) {
+				uint64_t p0 = (uint64_t) 0xD2511F53 * c0;
+				uint64_t p1 = (uint64_t) 0xCD9E8D57 * c2;
+				uint32_t n0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+				uint32_t n2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+				c0 = n0;
+				c1 = (uint32_t) p1;
+				c2 = n2;
+				c3 = (uint32_t) p0;
+				k0 += 0x9E3779B9;
+				k1 += 0xBB67AE85;
+			}
+			out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+		}
+
+#ifdef __AVX2__
+		// philox4x32 of 4 consecutive block counters at once (one per 64 bit lane), 16 words
+		static void philox4x32x4(const uint32_t counter[4], const uint32_t key[2], uint32_t out[16])
+		{
+			uint64_t lo[4], hi[4];
+			for(uint j = 0; j < 4; j++) {
+				uint32_t c = counter[0] + j;
+				lo[j] = c;
+				hi[j] = counter[1] + (c < counter[0] ? 1 : 0);
+			}
+			__m256i c0 = _mm256_loadu_si256((const __m256i*) lo);
+			__m256i c1 = _mm256_loadu_si256((const __m256i*) hi);
+			__m256i c2 = _mm256_set1_epi64x(counter[2]);
+			__m256i c3 = _mm256_set1_epi64x(counter[3]);
+			const __m256i m0 = _mm256_set1_epi64x(0xD2511F53);
+			const __m256i m1 = _mm256_set1_epi64x(0xCD9E8D57);
+			const __m256i low = _mm256_set1_epi64x(0xFFFFFFFF);
+			uint32_t k0 = key[0], k1 = key[1];
+
+			for(uint round = 0; round < 10; round++) {
+				__m256i p0 = _mm256_mul_epu32(m0, c0);
+				__m256i p1 = _mm256_mul_epu32(m1, c2);
+				__m256i n0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), c1), _mm256_set1_epi64x(k0));
+				__m256i n2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), c3), _mm256_set1_epi64x(k1));
+				c0 = n0;
+				c1 = _mm256_and_si256(p1, low);
+				c2 = n2;
+				c3 = _mm256_and_si256(p0, low);
+				k0 += 0x9E3779B9;
+				k1 += 0xBB67AE85;
+			}
+
+			uint64_t w[4][4];
+			_mm256_storeu_si256((__m256i*) w[0], c0);
+			_mm256_storeu_si256((__m256i*) w[1], c1);
+			_mm256_storeu_si256((__m256i*) w[2], c2);
+			_mm256_storeu_si256((__m256i*) w[3], c3);
+			for(uint j = 0; j < 4; j++)
+				for(uint k = 0; k < 4; k++)
+					out[4 * j + k] = (uint32_t) w[k][j];
+		}
+#endif
+
+protected:
+		uint seed_, config_, function_, repeat_;
+		uint32_t key_[2];
+		uint32_t counter_[4];	// block index (64 bit), repeat, function
+		uint32_t block_[4];
+		uint next_;				// next unused word in block_
+
+		// move the block counter n blocks on
+		void advance(uint32_t n)
+		{
+			uint32_t previous = counter_[0];
+			counter_[0] += n;
+			if(counter_[0] < previous)
+				++counter_[1];
+		}
+
+		uint32_t nextWord()
+		{
+			if(next_ == 4) {
+				philox4x32(counter_, key_, block_);
+				if(++counter_[0] == 0)
+					++counter_[1];
+				next_ = 0;
+			}
+			return block_[next_++];
+		}
+};
+typedef boost::shared_ptr<PhiloxRandomizer> PhiloxRandomizerP;
+
+#endif // PhiloxRandomizer_h
@@ -0,0 +1,76 @@
+#ifndef RunCounters_h
+#define RunCounters_h
+
+#include <ecf/ECF.h>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+/**
+ * \brief Named totals of the current run (e.g. evaluations skipped by the cache), appended to the run's stats file
+ *
+ * An algorithm looks a counter up once, id = RunCounters::instance().counter("name"), adds to it with add(id, value)
+ * and calls beginRun() in initialize(). Only the counters added to during the run are reported.
+ * After every run BatchDriver appends them to the run's stats file, after ECF's fitness statistics
+ * (next to PhaseProfiler's '# phase' lines), as comment lines
+ *	# counter <run> <name> <value>
+ * Only the algorithm's thread may add to the counters.
+ */
+class RunCounters
+{
+public:
+		static RunCounters& instance()
+		{
+			static RunCounters counters;
+			return counters;
+		}
+
+		// id of the named counter (registered on first use)
+		uint counter(const char *name)
+		{
+			for(uint i = 0; i < names_.size(); i++)
+				if(std::strcmp(names_[i], name) == 0)
+					return i;
+			names_.push_back(name);
+			value_.push_back(0);
+			used_.push_back(false);
+			return (uint) names_.size() - 1;
+		}
+
+		void add(uint id, double value)
+		{
+			value_[id] += value;
+			used_[id] = true;
+		}
+
+		// a new run starts: all counters are 0 and unused
+		void beginRun()
+		{
+			for(uint i = 0; i < names_.size(); i++) {
+				value_[i] = 0;
+				used_[i] = false;
+			}
+		}
+
+		// append the counters used in this run to the stats file, numbered with the run's repeat; a new run starts
+		void write(std::string statsFile, uint run)
+		{
+			std::ostringstream lines;
+			lines.precision(12);
+			for(uint i = 0; i < names_.size(); i++)
+				if(used_[i])
+					lines << "# counter " << run << " " << names_[i] << " " << value_[i] << "\n";
+			if(!lines.str().empty()) {
+				std::ofstream fout(statsFile.c_str(), std::ios::app);
+				fout << lines.str();
+			}
+			beginRun();
+		}
+
+protected:
+		std::vector<const char*> names_;
+		std::vector<double> value_;
+		std::vector<bool> used_;
+};
+
+#endif // RunCounters_h
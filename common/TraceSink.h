@@ -0,0 +1,338 @@
+#ifndef TraceSink_h
+#define TraceSink_h
+
+#include <ecf/ECF.h>
+#include <cstdio>
+#ifdef ECF_TRACE
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#endif
+
+/**
+ * \brief Timeline of begin/end events of every thread, exported in the Chrome trace format (Perfetto, chrome://tracing)
+ *
+ * Compiled in only with -DECF_TRACE: without it TRACE_SCOPE expands to nothing and the TraceSink calls are empty.
+ * TRACE_SCOPE("name") records a begin event and, at the end of the enclosing scope, the matching end event;
+ * PROFILE_PHASE (PhaseProfiler.h) records one as well, so every phase of advanceGeneration and every evaluation batch is traced.
+ *
+ * Every thread writes into its own ring buffer of ECF_TRACE_CAPACITY events (a power of two, default 65536), taken
+ * on its first event and linked into the sink with a compare-and-swap: recording an event takes no lock and no allocation.
+ * A full buffer overwrites its oldest events, so a long run keeps its most recent ones. The buffer of a thread that exited
+ * is taken over by the next new thread, which continues its track under its own name.
+ * Buffers are read only by writePart() and writeTrace(), after the threads that filled them are done.
+ *
+ * BatchDriver starts every job with '-trace traceNN_rNN.json': the job process writes its events there (writePart),
+ * and the parent process merges the parts with its own events (config setup, jobs on the pool workers, merged results)
+ * into trace.json. Timestamps come from the monotonic clock, which all processes share.
+ */
+#ifdef ECF_TRACE
+
+#ifndef ECF_TRACE_CAPACITY
+#define ECF_TRACE_CAPACITY 65536
+#endif
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__) (name)
+
+class TraceSink
+{
+public:
+		enum { CAPACITY = ECF_TRACE_CAPACITY };
+
+		static TraceSink& instance()
+		{
+			static TraceSink sink;
+			return sink;
+		}
+
+		// begin event, optionally with up to two integer arguments (argName NULL: none)
+		void begin(const char *name, const char *argName0 = NULL, int arg0 = 0, const char *argName1 = NULL, int arg1 = 0)
+		{
+			Event &event = next();
+			event.name = name;
+			event.type = 'B';
+			event.argName[0] = argName0;
+			event.arg[0] = arg0;
+			event.argName[1] = argName1;
+			event.arg[1] = arg1;
+			commit(event);
+		}
+
+		void end(const char *name)
+		{
+			Event &event = next();
+			event.name = name;
+			event.type = 'E';
+			event.argName[0] = event.argName[1] = NULL;
+			commit(event);
+		}
+
+		// name the calling thread in the timeline, unless it already has a name
+		void nameThread(const char *name)
+		{
+			ThreadBuffer &buffer = threadBuffer();
+			if(buffer.name == NULL)
+				buffer.name = name;
+		}
+
+		void setProcessName(std::string name)
+		{	processName_ = name;	}
+
+		// write this process's events to a part file, one JSON event per line
+		void writePart(std::string fileName)
+		{
+			std::ofstream fout(fileName.c_str());
+			writeEvents(fout, "\n");
+		}
+
+		// write the trace file: this process's events, followed by the events of the part files (which are removed)
+		void writeTrace(std::string fileName, const std::vector<std::string> &parts)
+		{
+			std::ofstream fout(fileName.c_str());
+			fout << "{\"traceEvents\":[\n";
+			bool first = writeEvents(fout, ",\n");
+			for(uint i = 0; i < parts.size(); i++) {
+				std::ifstream fin(parts[i].c_str());
+				std::string line;
+				while(std::getline(fin, line)) {
+					if(!first)
+						fout << ",\n";
+					fout << line;
+					first = false;
+				}
+				fin.close();
+				std::remove(parts[i].c_str());
+			}
+			fout << "\n],\"displayTimeUnit\":\"ms\"}\n";
+		}
+
+protected:
+		struct Event
+		{
+			const char *name;
+			char type;		// 'B' or 'E'
+			int64_t time;	// ns of the monotonic clock
+			const char *argName[2];
+			int arg[2];
+		};
+
+		struct ThreadBuffer
+		{
+			std::vector<Event> events;
+			std::atomic<uint64_t> written;	// events recorded so far (the last CAPACITY of them are kept)
+			std::atomic<bool> free;			// its thread exited
+			uint id;
+			const char *name;
+			ThreadBuffer *next;
+		};
+
+		std::atomic<ThreadBuffer*> head_;
+		std::atomic<uint> nThreads_;
+		std::string processName_;
+
+		TraceSink()
+		{
+			head_.store(NULL);
+			nThreads_.store(0);
+		}
+
+		// releases the buffer when its thread exits
+		struct ThreadHandle
+		{
+			ThreadBuffer *buffer;
+
+			ThreadHandle()
+			{	buffer = NULL;	}
+
+			~ThreadHandle()
+			{
+				if(buffer != NULL)
+					buffer->free.store(true, std::memory_order_release);
+			}
+		};
+
+		// the calling thread's buffer: on first use, a free one or a new one linked into the list
+		ThreadBuffer& threadBuffer()
+		{
+			static thread_local ThreadHandle handle;
+			if(handle.buffer == NULL)
+				handle.buffer = takeBuffer();
+			return *handle.buffer;
+		}
+
+		ThreadBuffer* takeBuffer()
+		{
+			for(ThreadBuffer *buffer = head_.load(); buffer != NULL; buffer = buffer->next) {
+				bool free = true;
+				if(buffer->free.compare_exchange_strong(free, false, std::memory_order_acquire)) {
+					buffer->name = NULL;	// the new thread names itself
+					return buffer;
+				}
+			}
+
+			ThreadBuffer *buffer = new ThreadBuffer;
+			buffer->events.resize(CAPACITY);
+			buffer->written.store(0);
+			buffer->free.store(false);
+			buffer->id = nThreads_++;
+			buffer->name = NULL;
+			buffer->next = head_.load();
+			while(!head_.compare_exchange_weak(buffer->next, buffer))
+				;
+			return buffer;
+		}
+
+		Event& next()
+		{
+			ThreadBuffer &buffer = threadBuffer();
+			return buffer.events[buffer.written.load(std::memory_order_relaxed) & (CAPACITY - 1)];
+		}
+
+		// time the event and publish it
+		void commit(Event &event)
+		{
+			event.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+			ThreadBuffer &buffer = threadBuffer();
+			buffer.written.store(buffer.written.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		static int processId()
+		{
+#ifdef _WIN32
+			return _getpid();
+#else
+			return (int) getpid();
+#endif
+		}
+
+		// write text as a quoted JSON string
+		static void writeString(std::ostream &out, const char *text)
+		{
+			out << '"';
+			for(const char *c = text; *c != '\0'; c++) {
+				if(*c == '"' || *c == '\\')
+					out << '\\' << *c;
+				else if((unsigned char) *c < 0x20) {
+					char escape[8];
+					std::sprintf(escape, "\\u%04x", (unsigned char) *c);
+					out << escape;
+				}
+				else
+					out << *c;
+			}
+			out << '"';
+		}
+
+		// write the events of all threads, separated by separator; returns whether nothing was written
+		bool writeEvents(std::ostream &out, const char *separator)
+		{
+			int pid = processId();
+			bool first = true;
+			if(!processName_.empty()) {
+				out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"args\":{\"name\":";
+				writeString(out, processName_.c_str());
+				out << "}}";
+				first = false;
+			}
+
+			for(ThreadBuffer *buffer = head_.load(); buffer != NULL; buffer = buffer->next) {
+				if(buffer->name != NULL) {
+					out << (first ? "" : separator) << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << buffer->id
+						<< ",\"args\":{\"name\":";
+					writeString(out, buffer->name);
+					out << "}}";
+					first = false;
+				}
+
+				uint64_t written = buffer->written.load(std::memory_order_acquire);
+				uint64_t oldest = (written > (uint64_t) CAPACITY) ? written - CAPACITY : 0;
+				uint depth = 0;
+				for(uint64_t i = oldest; i < written; i++) {
+					const Event &event = buffer->events[i & (CAPACITY - 1)];
+					// the begin events of the oldest end events may have been overwritten
+					if(event.type == 'E' && depth == 0)
+						continue;
+					if(event.type == 'B')
+						depth++;
+					else
+						depth--;
+
+					char timestamp[32];
+					std::sprintf(timestamp, "%lld.%03d", (long long) (event.time / 1000), (int) (event.time % 1000));
+					out << (first ? "" : separator) << "{\"name\":";
+					writeString(out, event.name);
+					out << ",\"ph\":\"" << event.type << "\",\"ts\":" << timestamp
+						<< ",\"pid\":" << pid << ",\"tid\":" << buffer->id;
+					if(event.argName[0] != NULL) {
+						out << ",\"args\":{";
+						writeString(out, event.argName[0]);
+						out << ":" << event.arg[0];
+						if(event.argName[1] != NULL) {
+							out << ",";
+							writeString(out, event.argName[1]);
+							out << ":" << event.arg[1];
+						}
+						out << "}";
+					}
+					out << "}";
+					first = false;
+				}
+			}
+			return first;
+		}
+};
+
+
+/**
+ * \brief Records a begin event on construction and the matching end event on destruction
+ */
+class TraceScope
+{
+public:
+		explicit TraceScope(const char *name)
+		{
+			name_ = name;
+			TraceSink::instance().begin(name);
+		}
+
+		~TraceScope()
+		{	TraceSink::instance().end(name_);	}
+
+protected:
+		const char *name_;
+};
+
+#else
+
+#define TRACE_SCOPE(name)
+
+class TraceSink
+{
+public:
+		static TraceSink& instance()
+		{
+			static TraceSink sink;
+			return sink;
+		}
+
+		void begin(const char*, const char* = NULL, int = 0, const char* = NULL, int = 0)
+		{}
+
+		void end(const char*)
+		{}
+
+		void nameThread(const char*)
+		{}
+};
+
+#endif
+
+#endif // TraceSink_h
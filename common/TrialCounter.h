@@ -0,0 +1,139 @@
+#ifndef TrialCounter_h
+#define TrialCounter_h
+
+#include <ecf/ECF.h>
+
+/**
+ * \brief Trial counters of a deme's food sources, bucketed by value, with the maximum trial always at hand
+ *
+ * Every counter is in the bucket (a linked list) of its value; increment() moves it one bucket up and reset() to bucket 0,
+ * both in O(1). The maximum only grows by one per increment, so walking it down over empty buckets after a reset
+ * is amortized O(1) as well, and getMax()/argMax() don't scan the deme.
+ * Among the counters with the maximum value, argMax() returns the one that reached it first.
+ */
+class TrialBuckets
+{
+public:
+		// n counters, all 0; the buckets of trials up to maxTrial are allocated up front
+		void initialize(uint n, uint maxTrial = 0)
+		{
+			trial_.assign(n, 0);
+			prev_.resize(n);
+			next_.resize(n);
+			head_.reserve(maxTrial + 1);
+			tail_.reserve(maxTrial + 1);
+			head_.assign(1, NONE);
+			tail_.assign(1, NONE);
+			max_ = 0;
+			for(uint i = 0; i < n; i++)
+				link(i);
+		}
+
+		uint operator[] (uint i)
+		{	return trial_[i];	}
+
+		void increment(uint i)
+		{
+			unlink(i);
+			trial_[i]++;
+			if(trial_[i] >= head_.size()) {
+				head_.push_back(NONE);
+				tail_.push_back(NONE);
+			}
+			link(i);
+			if(trial_[i] > max_)
+				max_ = trial_[i];
+		}
+
+		void reset(uint i)
+		{
+			unlink(i);
+			trial_[i] = 0;
+			link(i);
+			while(max_ > 0 && head_[max_] == NONE)
+				max_--;
+		}
+
+		// maximum trial
+		uint getMax()
+		{	return max_;	}
+
+		// counter with the maximum trial
+		uint argMax()
+		{	return head_[max_];	}
+
+protected:
+		enum { NONE = 0xFFFFFFFFu };	// no counter
+		std::vector<uint> trial_;
+		std::vector<uint> prev_, next_;		// neighbours in the bucket list
+		std::vector<uint> head_, tail_;		// first and last counter of each bucket
+		uint max_;
+
+		// append counter i to the bucket of its value
+		void link(uint i)
+		{
+			uint t = trial_[i];
+			prev_[i] = tail_[t];
+			next_[i] = NONE;
+			if(tail_[t] == NONE)
+				head_[t] = i;
+			else
+				next_[tail_[t]] = i;
+			tail_[t] = i;
+		}
+
+		void unlink(uint i)
+		{
+			uint t = trial_[i];
+			if(prev_[i] == NONE)
+				head_[t] = next_[i];
+			else
+				next_[prev_[i]] = next_[i];
+			if(next_[i] == NONE)
+				tail_[t] = prev_[i];
+			else
+				prev_[next_[i]] = prev_[i];
+		}
+};
+
+
+/**
+ * \brief TrialBuckets of every deme, indexed by Individual::index (see IndividualAttribute)
+ *
+ * Algorithms call clear() in initialize(): every run starts with all trials 0.
+ * maxTrial is the trial the algorithm usually stays below (ABC: a food source is abandoned after limit trials),
+ * so steady-state generations don't add buckets.
+ */
+class TrialCounter
+{
+public:
+		TrialCounter()
+		{	maxTrial_ = 0;	}
+
+		void clear(uint maxTrial = 0)
+		{
+			demes_.clear();
+			trials_.clear();
+			maxTrial_ = maxTrial;
+		}
+
+		// trial counters of the deme's food sources (created, all 0, on first use)
+		TrialBuckets& of(DemeP deme)
+		{
+			for(uint i = 0; i < demes_.size(); i++)
+				if(demes_[i] == deme.get())
+					return trials_[i];
+
+			demes_.push_back(deme.get());
+			trials_.push_back(TrialBuckets());
+			trials_.back().initialize(deme->getSize(), maxTrial_);
+			return trials_.back();
+		}
+
+protected:
+		std::vector<Deme*> demes_;
+		std::vector<TrialBuckets> trials_;
+		uint maxTrial_;
+};
+
+#endif // TrialCounter_h
@@ -0,0 +1,24 @@
+#ifndef Check_h
+#define Check_h
+
+#include <iostream>
+
+/**
+ * \brief Minimal checks for the tests of the common headers
+ *
+ * CHECK(condition) reports a failed condition with its file and line and counts it;
+ * a test's main() returns CHECK_RESULT(), which is nonzero if any check failed.
+ */
+static int checkFailures_ = 0;
+
+#define CHECK(condition) \
+	do { \
+		if(!(condition)) { \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+			checkFailures_++; \
+		} \
+	} while(0)
+
+#define CHECK_RESULT() (checkFailures_ == 0 ? 0 : 1)
+
+#endif // Check_h
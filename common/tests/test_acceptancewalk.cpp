@@ -0,0 +1,88 @@
+// AcceptanceWalk: accepted items have the distribution of the round-robin acceptance loop
+#include <ecf/ECF.h>
+#include "../AcceptanceWalk.h"
+#include "../PhiloxRandomizer.h"
+#include "Check.h"
+#include <cmath>
+
+const uint nPhases = 40000;
+
+// the loop AcceptanceWalk replaces (ABC's onlooker phase): n accepted items per phase, counted by their turn
+std::vector<std::vector<uint> > loopCounts(const std::vector<double> &p, RandomizerP randomizer)
+{
+	uint n = (uint) p.size();
+	std::vector<std::vector<uint> > count(n, std::vector<uint>(n, 0));
+	for(uint phase = 0; phase < nPhases; phase++) {
+		uint i = 0;
+		for(uint turn = 0; turn < n; ) {
+			uint item = i++ % n;
+			if(randomizer->getRandomDouble() < p[item])
+				count[turn++][item]++;
+		}
+	}
+	return count;
+}
+
+std::vector<std::vector<uint> > walkCounts(const std::vector<double> &p, RandomizerP randomizer)
+{
+	uint n = (uint) p.size();
+	std::vector<std::vector<uint> > count(n, std::vector<uint>(n, 0));
+	AcceptanceWalk walk;
+	for(uint phase = 0; phase < nPhases; phase++) {
+		walk.build(p);
+		for(uint turn = 0; turn < n; turn++) {
+			uint item = walk.sample(randomizer);
+			CHECK(item < n);
+			if(item < n)
+				count[turn][item]++;
+		}
+	}
+	return count;
+}
+
+// the item accepted at every turn of a phase has the same distribution as in the loop
+// (5 standard deviations of the difference of two binomial counts)
+void compare(const std::vector<double> &p, RandomizerP randomizer)
+{
+	std::vector<std::vector<uint> > expected = loopCounts(p, randomizer);
+	std::vector<std::vector<uint> > sampled = walkCounts(p, randomizer);
+	for(uint turn = 0; turn < p.size(); turn++)
+		for(uint item = 0; item < p.size(); item++) {
+			double q = (expected[turn][item] + sampled[turn][item]) / (2. * nPhases);
+			double tolerance = 5 * std::sqrt(2 * nPhases * q * (1 - q)) + 1;
+			CHECK(std::fabs((double) expected[turn][item] - (double) sampled[turn][item]) <= tolerance);
+			if(p[item] <= 0)
+				CHECK(sampled[turn][item] == 0);
+		}
+}
+
+int main()
+{
+	PhiloxRandomizer *philox = new PhiloxRandomizer;
+	philox->setStream(4, 0, 0, 1);
+	RandomizerP randomizer (philox);
+
+	// ABC probabilities: the best source is accepted for sure, the others with 0.1 + 0.9 * best / fitness
+	double abc[] = { 0.2, 1, 0.55, 0.1, 0.73 };
+	compare(std::vector<double>(abc, abc + 5), randomizer);
+
+	// mixed sign minimization values give probabilities below 0 and above 1
+	double mixed[] = { 1, 1.33, -3.5, -1.75 };
+	compare(std::vector<double>(mixed, mixed + 4), randomizer);
+
+	// no sure acceptance: the walk may go around several times
+	double low[] = { 0.05, 0.3, 0.01, 0.2, 0, 0.1 };
+	compare(std::vector<double>(low, low + 6), randomizer);
+
+	// a single item
+	compare(std::vector<double>(1, 0.4), randomizer);
+
+	// nothing can be accepted: the items in turn
+	std::vector<double> none(3, -1.);
+	AcceptanceWalk walk;
+	walk.build(none);
+	for(uint i = 0; i < 7; i++)
+		CHECK(walk.sample(randomizer) == i % 3);
+
+	return CHECK_RESULT();
+}
@@ -0,0 +1,78 @@
+// AliasTable: samples follow the weights
+#include <ecf/ECF.h>
+#include "../AliasTable.h"
+#include "../PhiloxRandomizer.h"
+#include "Check.h"
+#include <cmath>
+#include <algorithm>
+
+// sample n times and compare the frequencies with the normalized weights
+void checkFrequencies(AliasTable &table, const std::vector<double> &weights, RandomizerP randomizer)
+{
+	const uint n = 200000;
+	std::vector<uint> count(weights.size(), 0);
+	for(uint i = 0; i < n; i++) {
+		uint index = table.sample(randomizer);
+		CHECK(index < weights.size());
+		if(index < weights.size())
+			count[index]++;
+	}
+
+	// negative weights count as 0
+	double sum = 0;
+	for(uint i = 0; i < weights.size(); i++)
+		sum += std::max(weights[i], 0.);
+	for(uint i = 0; i < weights.size(); i++) {
+		double p = (sum > 0) ? std::max(weights[i], 0.) / sum : 1. / weights.size();
+		if(p == 0)
+			CHECK(count[i] == 0);
+		// 5 standard deviations of the binomial count
+		CHECK(std::fabs(count[i] - n * p) <= 5 * std::sqrt(n * p * (1 - p)) + 1);
+	}
+}
+
+int main()
+{
+	PhiloxRandomizer *philox = new PhiloxRandomizer;
+	philox->setStream(9, 0, 0, 1);
+	RandomizerP randomizer (philox);
+	AliasTable table;
+
+	double skewed[] = { 1, 2, 3, 0, 4, 0.5, 100, 0 };
+	std::vector<double> weights(skewed, skewed + 8);
+	table.build(weights);
+	CHECK(table.size() == 8);
+	checkFrequencies(table, weights, randomizer);
+
+	// a single weight
+	weights.assign(1, 3.5);
+	table.build(weights);
+	checkFrequencies(table, weights, randomizer);
+
+	// all zero weights: uniform
+	weights.assign(5, 0.);
+	table.build(weights);
+	checkFrequencies(table, weights, randomizer);
+
+	// negative weights (ABC probabilities of minimization values of mixed sign) are never sampled
+	double mixed[] = { 1, 1.33, -3.5, -1.75 };
+	weights.assign(mixed, mixed + 4);
+	table.build(weights);
+	checkFrequencies(table, weights, randomizer);
+
+	// no positive weight: uniform
+	weights.assign(mixed + 2, mixed + 4);
+	weights.push_back(0);
+	table.build(weights);
+	checkFrequencies(table, weights, randomizer);
+
+	// rebuilt with more columns and very uneven weights
+	weights.clear();
+	for(uint i = 0; i < 50; i++)
+		weights.push_back(std::pow(1.3, (double) i));
+	table.build(weights);
+	CHECK(table.size() == 50);
+	checkFrequencies(table, weights, randomizer);
+
+	return CHECK_RESULT();
+}
@@ -0,0 +1,189 @@
+// CloneArena: rows added, cloned, kept, selected and copied back to antibodies;
+// clones share their antibody's coordinates until they are written (copy-on-write)
+#include <ecf/ECF.h>
+#include "../CloneArena.h"
+#include "Check.h"
+
+IndividualP newAntibody(uint dimension, double first, double fitnessValue)
+{
+	IndividualP antibody (new Individual);
+	FloatingPointP flp (new FloatingPoint::FloatingPoint);
+	flp->realValue.resize(dimension);
+	for(uint d = 0; d < dimension; d++)
+		flp->realValue[d] = first + d;
+	antibody->push_back(flp);
+	antibody->fitness = (FitnessP) new FitnessMin;
+	antibody->fitness->setValue(fitnessValue);
+	return antibody;
+}
+
+FitnessP newFitness(double value)
+{
+	FitnessP fitness (new FitnessMin);
+	fitness->setValue(value);
+	return fitness;
+}
+
+std::vector<double>& coordinates(IndividualP antibody)
+{
+	FloatingPointP flp = boost::dynamic_pointer_cast<FloatingPoint::FloatingPoint> (antibody->getGenotype(0));
+	return flp->realValue;
+}
+
+bool rowEquals(CloneArena &arena, uint i, const std::vector<double> &expected)
+{
+	const double *row = arena.constRow(i);
+	for(uint d = 0; d < expected.size(); d++)
+		if(row[d] != expected[d])
+			return false;
+	return true;
+}
+
+// clones with their own coordinates
+void checkOwnRows(uint dimension)
+{
+	CloneArena arena;
+	arena.reserve(2, dimension);
+	std::vector<std::vector<double> > rows(6, std::vector<double>(dimension));
+	for(uint i = 0; i < rows.size(); i++)
+		for(uint d = 0; d < dimension; d++)
+			rows[i][d] = 10. * i + d;
+
+	// the arena grows past its reserve
+	for(uint i = 0; i < rows.size(); i++)
+		CHECK(arena.add(&rows[i][0], newFitness(6. - i), i, i / 2) == i);
+	CHECK(arena.size() == 6 && arena.getDimension() == dimension);
+	for(uint i = 0; i < rows.size(); i++) {
+		CHECK(!arena.isShared(i));
+		CHECK(rowEquals(arena, i, rows[i]));
+		CHECK(arena.fitness[i]->getValue() == 6. - i && arena.age[i] == i && arena.parent[i] == i / 2 && !arena.dirty[i]);
+	}
+	CHECK(arena.add(&rows[0][0], FitnessP(), 0, 0) == 6 && arena.dirty[6]);
+	arena.truncate(6);
+	CHECK(arena.size() == 6);
+
+	// a clone is a separate copy
+	uint copy = arena.clone(2);
+	CHECK(rowEquals(arena, copy, rows[2]) && arena.fitness[copy] == arena.fitness[2] && arena.parent[copy] == 1);
+	arena.row(copy)[0] = -1;
+	CHECK(rowEquals(arena, 2, rows[2]));
+
+	// keep reorders and drops rows
+	std::vector<uint> kept;
+	kept.push_back(copy);
+	kept.push_back(4);
+	kept.push_back(0);
+	arena.keep(kept);
+	CHECK(arena.size() == 3);
+	CHECK(arena.constRow(0)[0] == -1 && arena.parent[0] == 1);
+	CHECK(rowEquals(arena, 1, rows[4]) && rowEquals(arena, 2, rows[0]));
+
+	// rows of another arena
+	CloneArena other;
+	other.reserve(1, dimension);
+	other.add(arena, 1);
+	CHECK(rowEquals(other, 0, rows[4]) && other.fitness[0] == arena.fitness[1]);
+	other.set(0, arena, 2);
+	CHECK(rowEquals(other, 0, rows[0]) && other.age[0] == 0);
+
+	// copied back to antibodies
+	IndividualP target = newAntibody(1, 0, 0);
+	arena.copyTo(1, target);
+	CHECK(coordinates(target) == rows[4] && target->fitness == arena.fitness[1]);
+	std::vector<double> destination(dimension);
+	arena.copyCoordinates(2, &destination[0]);
+	CHECK(destination == rows[0]);
+
+	// best and selectBest go by fitness (smaller is better)
+	CHECK(arena.best() == 1);
+	arena.selectBest(2);
+	CHECK(arena.size() == 2);
+	CHECK(arena.fitness[0]->getValue() + arena.fitness[1]->getValue() == 2. + 4.);
+
+	// an emptied arena starts over
+	arena.reserve(4, dimension);
+	CHECK(arena.size() == 0);
+	arena.add(&rows[5][0], newFitness(0), 0, 0);
+	CHECK(rowEquals(arena, 0, rows[5]));
+}
+
+// clones of deme antibodies share their coordinates until they are written
+void checkSharedRows(uint dimension)
+{
+	CloneArena arena;
+	arena.reserve(4, dimension);
+	IndividualP a = newAntibody(dimension, 1, 10), b = newAntibody(dimension, 100, 5);
+	std::vector<double> aValues = coordinates(a), bValues = coordinates(b);
+
+	CHECK(arena.add(a, 0, 0) == 0);
+	CHECK(arena.add(b, 2, 1) == 1);
+	CHECK(arena.isShared(0) && arena.isShared(1));
+	CHECK(!arena.dirty[0] && arena.age[1] == 2 && arena.parent[1] == 1);
+
+	// the arena holds a copy: changing the deme antibody doesn't change the row
+	coordinates(a)[0] = -1;
+	CHECK(rowEquals(arena, 0, aValues));
+
+	// clones of shared rows share too (the arena grows past its reserve)
+	for(uint k = 0; k < 6; k++)
+		arena.clone(k % 2);
+	CHECK(arena.size() == 8);
+	for(uint i = 0; i < arena.size(); i++) {
+		CHECK(arena.isShared(i));
+		CHECK(rowEquals(arena, i, i % 2 ? bValues : aValues));
+		CHECK(arena.fitness[i] == (i % 2 ? b->fitness : a->fitness));
+	}
+
+	// writing a clone gives it its own row, the antibody and the other clones keep theirs
+	double *row = arena.row(2);
+	CHECK(!arena.isShared(2));
+	CHECK(rowEquals(arena, 2, aValues));
+	row[dimension - 1] = 42;
+	CHECK(arena.constRow(2)[dimension - 1] == 42);
+	CHECK(rowEquals(arena, 0, aValues) && rowEquals(arena, 4, aValues));
+
+	// a clone of an own row is an own row with the same coordinates
+	uint copy = arena.clone(2);
+	CHECK(!arena.isShared(copy));
+	CHECK(arena.constRow(copy)[dimension - 1] == 42);
+	arena.row(copy)[0] = 7;
+	CHECK(arena.constRow(2)[0] == aValues[0]);
+
+	// keep reorders rows, shared rows stay shared
+	std::vector<uint> rows;
+	rows.push_back(copy);
+	rows.push_back(1);
+	rows.push_back(2);
+	arena.keep(rows);
+	CHECK(arena.size() == 3);
+	CHECK(!arena.isShared(0) && arena.isShared(1) && !arena.isShared(2));
+	CHECK(arena.constRow(0)[0] == 7 && arena.constRow(0)[dimension - 1] == 42);
+	CHECK(rowEquals(arena, 1, bValues));
+	CHECK(arena.constRow(2)[0] == aValues[0] && arena.constRow(2)[dimension - 1] == 42);
+
+	// shared rows are copied out like own rows
+	IndividualP target = newAntibody(1, 0, 0);
+	arena.copyTo(1, target);
+	CHECK(coordinates(target) == bValues && target->fitness == b->fitness);
+	std::vector<double> destination(dimension);
+	arena.copyCoordinates(1, &destination[0]);
+	CHECK(destination == bValues);
+	CloneArena other;
+	other.reserve(1, dimension);
+	other.add(arena, 1);
+	CHECK(!other.isShared(0) && rowEquals(other, 0, bValues));
+
+	// an emptied arena starts over with new antibodies
+	arena.reserve(4, dimension);
+	arena.add(b, 0, 0);
+	CHECK(arena.isShared(0) && rowEquals(arena, 0, bValues));
+}
+
+int main()
+{
+	checkOwnRows(5);
+	checkOwnRows(7);
+	checkSharedRows(5);
+	checkSharedRows(7);
+	return CHECK_RESULT();
+}
@@ -0,0 +1,130 @@
+// HypermutationKernel: planned mutations give the clones of the scalar mutation loop bit for bit
+#include <ecf/ECF.h>
+#include "../HypermutationKernel.h"
+#include "Check.h"
+#include <cmath>
+
+// deterministic randomizer that is not a PhiloxRandomizer (plan() draws one number at a time from it)
+class XorShiftRandomizer : public Randomizer
+{
+public:
+		XorShiftRandomizer(uint64_t seed)
+		{	state_ = seed;	}
+
+		double getRandomDouble()
+		{	return (next() >> 11) * (1. / 9007199254740992.);	}
+
+		int getRandomInteger(int p, int q)
+		{	return p + getRandomInteger(q - p + 1);	}
+
+		int getRandomInteger(int size)
+		{	return (int) (next() % (uint64_t) size);	}
+
+		bool initialize(StateP)
+		{	return true;	}
+
+protected:
+		uint64_t state_;
+
+		uint64_t next()
+		{
+			state_ ^= state_ << 13;
+			state_ ^= state_ >> 7;
+			state_ ^= state_ << 17;
+			return state_;
+		}
+};
+
+const double lbound = -5, ubound = 5;
+const uint dimension = 5, nClones = 40;
+
+// the mutation loop of CLONALG and opt-IA before the kernel
+void scalarMutation(StateP state, std::vector<double> &antibodyVars, uint M)
+{
+	for(uint j = 0; j < M; j++) {
+		uint param = state->getRandomizer()->getRandomInteger((int) antibodyVars.size());
+		double randDouble1 = state->getRandomizer()->getRandomDouble();
+		double randDouble2 = state->getRandomizer()->getRandomDouble();
+		double value = antibodyVars[param] + (1-2*randDouble1)* 0.2 * (ubound - lbound) * pow(2, -16*randDouble2);
+		if(value > ubound)
+			value = ubound;
+		else if(value < lbound)
+			value = lbound;
+		antibodyVars[param] = value;
+	}
+}
+
+// clone i starts at coordinates near the bounds (so clamping happens) and gets i % 7 + 1 mutations
+std::vector<double> startingClone(uint i)
+{
+	std::vector<double> clone(dimension);
+	for(uint d = 0; d < dimension; d++)
+		clone[d] = (d % 2 ? ubound : lbound) * (1 - 0.01 * ((i + d) % 5));
+	return clone;
+}
+
+// mutate all clones with the scalar loop and with the kernel, each drawing from its own copy of the same stream
+void compare(RandomizerP scalarRandomizer, RandomizerP kernelRandomizer, bool exact)
+{
+	StateP scalarState (new State);
+	scalarState->setRandomizer(scalarRandomizer);
+	StateP kernelState (new State);
+	kernelState->setRandomizer(kernelRandomizer);
+
+	std::vector<std::vector<double> > expected(nClones), mutated(nClones);
+	std::vector<uint> first(nClones + 1, 0);
+	for(uint i = 0; i < nClones; i++) {
+		expected[i] = mutated[i] = startingClone(i);
+		scalarMutation(scalarState, expected[i], i % 7 + 1);
+		first[i + 1] = first[i] + i % 7 + 1;
+	}
+
+	HypermutationKernel kernel;
+	kernel.setExact(exact);
+	kernel.plan(kernelState, first[nClones], dimension, lbound, ubound);
+	for(uint i = 0; i < nClones; i++) {
+		std::vector<double> before = mutated[i];
+		bool changed = kernel.apply(&mutated[i][0], first[i], first[i + 1], lbound, ubound);
+		CHECK(changed == (mutated[i] != before));
+		for(uint d = 0; d < dimension; d++) {
+			if(exact)
+				CHECK(mutated[i][d] == expected[i][d]);
+			else
+				CHECK(std::fabs(mutated[i][d] - expected[i][d]) <= 1e-12 * (ubound - lbound));
+			CHECK(mutated[i][d] >= lbound && mutated[i][d] <= ubound);
+		}
+	}
+
+	// both drew the same numbers
+	CHECK(scalarRandomizer->getRandomDouble() == kernelRandomizer->getRandomDouble());
+}
+
+int main()
+{
+	for(uint exact = 0; exact < 2; exact++) {
+		compare((RandomizerP) new XorShiftRandomizer(88172645463325252ull),
+			(RandomizerP) new XorShiftRandomizer(88172645463325252ull), exact == 1);
+
+		PhiloxRandomizer *scalarPhilox = new PhiloxRandomizer;
+		PhiloxRandomizer *kernelPhilox = new PhiloxRandomizer;
+		scalarPhilox->setStream(3, 1, 8, 2);
+		kernelPhilox->setStream(3, 1, 8, 2);
+		// start inside a block of words
+		scalarPhilox->getRandomInteger(2);
+		kernelPhilox->getRandomInteger(2);
+		compare((RandomizerP) scalarPhilox, (RandomizerP) kernelPhilox, exact == 1);
+	}
+
+	// no mutations: nothing is drawn and nothing changes
+	StateP state (new State);
+	PhiloxRandomizer *philox = new PhiloxRandomizer;
+	state->setRandomizer((RandomizerP) philox);
+	HypermutationKernel kernel;
+	kernel.plan(state, 0, dimension, lbound, ubound);
+	std::vector<double> clone = startingClone(0);
+	CHECK(!kernel.apply(&clone[0], 0, 0, lbound, ubound));
+	PhiloxRandomizer fresh;
+	CHECK(philox->getRandomDouble() == fresh.getRandomDouble());
+
+	return CHECK_RESULT();
+}
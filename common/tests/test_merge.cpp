@@ -0,0 +1,105 @@
+// BatchDriver::mergeFiles: per-repeat parts merged in repeat order, stats runs renumbered, parts kept if one is missing;
+// BatchDriver::writeRunStats: the stats file of a run, as the driver writes it
+#include <ecf/ECF.h>
+#include "../BatchDriver.h"
+#include "Check.h"
+#include <fstream>
+#include <sstream>
+
+class MergeDriver : public BatchDriver
+{
+public:
+		MergeDriver(int argc, char **argv) : BatchDriver(argc, argv)
+		{}
+
+		using BatchDriver::mergeFiles;
+		using BatchDriver::runNumberLength;
+		using BatchDriver::writeRunStats;
+};
+
+void writeFile(std::string name, std::string text)
+{
+	std::ofstream fout(name.c_str());
+	fout << text;
+}
+
+std::string readFile(std::string name)
+{
+	std::ifstream fin(name.c_str());
+	std::ostringstream text;
+	text << fin.rdbuf();
+	return text.str();
+}
+
+bool exists(std::string name)
+{
+	std::ifstream fin(name.c_str());
+	return (bool) fin;
+}
+
+int main()
+{
+	char program[] = "test_merge", config[] = "config.txt";
+	char *argv[] = { program, config };
+	MergeDriver driver(2, argv);
+
+	CHECK(MergeDriver::runNumberLength("12\t0.5") == 2);
+	CHECK(MergeDriver::runNumberLength("3 1e-08") == 1);
+	CHECK(MergeDriver::runNumberLength("3e-08") == 0);
+	CHECK(MergeDriver::runNumberLength("# counter 1 cacheHits 5") == 0);
+	CHECK(MergeDriver::runNumberLength("run\tfitness") == 0);
+
+	// stats: each part numbers its runs from 1, with its own header and '#' lines
+	const std::string header = "run\tbest\tevaluations\n";
+	std::vector<std::string> parts;
+	std::vector<uint> firstRepeats;
+	parts.push_back("merge_stats_r01.txt");
+	parts.push_back("merge_stats_r03.txt");
+	firstRepeats.push_back(1);
+	firstRepeats.push_back(3);
+	writeFile(parts[0], header + "1\t0.5\t100\n2\t0.25\t200\n\n# counter 1 cacheHits 5\n");
+	writeFile(parts[1], header + "1\t0.125\t300\n# phase 3 total evaluate 10 0.01 0 0 0\n");
+	driver.mergeFiles("merge_stats.txt", parts, firstRepeats, true);
+	CHECK(readFile("merge_stats.txt") == header
+		+ "1\t0.5\t100\n2\t0.25\t200\n# counter 1 cacheHits 5\n"
+		+ "3\t0.125\t300\n# phase 3 total evaluate 10 0.01 0 0 0\n");
+	CHECK(!exists(parts[0]) && !exists(parts[1]));
+
+	// logs are appended as they are
+	writeFile(parts[0], "log of repeat 1\n");
+	writeFile(parts[1], "1\tlog of repeat 3\n");
+	driver.mergeFiles("merge_log.txt", parts, firstRepeats, false);
+	CHECK(readFile("merge_log.txt") == "log of repeat 1\n1\tlog of repeat 3\n");
+
+	// a missing part leaves the target as it was and keeps the other parts
+	writeFile(parts[0], header + "1\t9\t9\n");
+	driver.mergeFiles("merge_stats.txt", parts, firstRepeats, true);
+	CHECK(readFile("merge_stats.txt").find("\t9\t") == std::string::npos);
+	CHECK(exists(parts[0]));
+	CHECK(!exists("merge_stats.txt.merge"));
+
+	std::remove(parts[0].c_str());
+
+	// run stats written by the driver, fitness 1, 2, 3 and 6 in the final population; merged like the other parts
+	std::vector<IndividualP> individuals;
+	const double values[] = { 2, 6, 1, 3 };
+	for(uint i = 0; i < 4; i++) {
+		IndividualP individual (new Individual);
+		individual->fitness = (FitnessP) new FitnessMin;
+		individual->fitness->setValue(values[i]);
+		individuals.push_back(individual);
+	}
+	const std::string statsHeader = "run\tfit_min\tfit_max\tfit_avg\tfit_std\tevaluations\tgenerations\ttime\n";
+	MergeDriver::writeRunStats(parts[0], 1, individuals, 5000, 50, 0.5);
+	CHECK(readFile(parts[0]) == statsHeader + "1\t1\t6\t3\t1.87082869339\t5000\t50\t0.5\n");
+	individuals.resize(1);
+	MergeDriver::writeRunStats(parts[1], 3, individuals, 100, 1, 2);
+	CHECK(readFile(parts[1]) == statsHeader + "3\t2\t2\t2\t0\t100\t1\t2\n");
+	driver.mergeFiles("merge_stats.txt", parts, firstRepeats, true);
+	CHECK(readFile("merge_stats.txt") == statsHeader
+		+ "1\t1\t6\t3\t1.87082869339\t5000\t50\t0.5\n" + "3\t2\t2\t2\t0\t100\t1\t2\n");
+
+	std::remove("merge_stats.txt");
+	std::remove("merge_log.txt");
+	return CHECK_RESULT();
+}
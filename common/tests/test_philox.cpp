@@ -0,0 +1,141 @@
+// PhiloxRandomizer: known answers, replayable and independent streams, fillWords in the order of single draws
+#include <ecf/ECF.h>
+#include "../PhiloxRandomizer.h"
+#include "Check.h"
+#include <thread>
+
+// Random123 known-answer vectors of Philox4x32-10
+void checkKnownAnswers()
+{
+	const uint32_t counter[3][4] = {
+		{ 0, 0, 0, 0 },
+		{ 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff },
+		{ 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 } };
+	const uint32_t key[3][2] = {
+		{ 0, 0 },
+		{ 0xffffffff, 0xffffffff },
+		{ 0xa4093822, 0x299f31d0 } };
+	const uint32_t expected[3][4] = {
+		{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 },
+		{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd },
+		{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } };
+
+	for(uint i = 0; i < 3; i++) {
+		uint32_t out[4];
+		PhiloxRandomizer::philox4x32(counter[i], key[i], out);
+		for(uint j = 0; j < 4; j++)
+			CHECK(out[j] == expected[i][j]);
+	}
+}
+
+// the same stream gives the same numbers, after other draws and in a new randomizer
+void checkReplay()
+{
+	PhiloxRandomizer first, second;
+	first.setStream(7, 3, 12, 5);
+	std::vector<double> numbers;
+	for(uint i = 0; i < 1000; i++)
+		numbers.push_back(first.getRandomDouble());
+
+	for(uint i = 0; i < 123; i++)
+		second.getRandomInteger(10);
+	second.setStream(7, 3, 12, 5);
+	for(uint i = 0; i < numbers.size(); i++)
+		CHECK(second.getRandomDouble() == numbers[i]);
+
+	first.setStream(7, 3, 12, 5);
+	CHECK(first.getRandomDouble() == numbers[0]);
+}
+
+// every part of the key gives a different stream
+void checkDistinctStreams()
+{
+	const uint streams[5][4] = { { 1, 1, 1, 1 }, { 2, 1, 1, 1 }, { 1, 2, 1, 1 }, { 1, 1, 2, 1 }, { 1, 1, 1, 2 } };
+	std::vector<double> first(5);
+	for(uint i = 0; i < 5; i++) {
+		PhiloxRandomizer randomizer;
+		randomizer.setStream(streams[i][0], streams[i][1], streams[i][2], streams[i][3]);
+		first[i] = randomizer.getRandomDouble();
+	}
+	for(uint i = 0; i < 5; i++)
+		for(uint j = i + 1; j < 5; j++)
+			CHECK(first[i] != first[j]);
+}
+
+// fillWords hands out the words the single draws would have used, from any position in a block
+void checkFillWords()
+{
+	const uint lengths[] = { 0, 1, 3, 4, 5, 15, 16, 17, 63, 100 };
+	for(uint offset = 0; offset < 4; offset++) {
+		for(uint l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+			uint n = 2 * lengths[l];	// a double takes two words
+			PhiloxRandomizer bulk, single;
+			bulk.setStream(11, 22, 3, 4);
+			single.setStream(11, 22, 3, 4);
+			std::vector<uint32_t> skip(offset + 1);
+			bulk.fillWords(&skip[0], offset);
+			for(uint i = 0; i < offset; i++)
+				CHECK(single.getRandomInteger(1 << 16) == PhiloxRandomizer::toInteger(skip[i], 1 << 16));
+
+			std::vector<uint32_t> words(n + 1);
+			bulk.fillWords(&words[0], n);
+			for(uint i = 0; i < n; i += 2)
+				CHECK(single.getRandomDouble() == PhiloxRandomizer::toDouble(words[i], words[i + 1]));
+			// both continue from the same word
+			CHECK(bulk.getRandomDouble() == single.getRandomDouble());
+		}
+	}
+}
+
+// streams drawn on other threads give the numbers a single thread does
+void checkThreads()
+{
+	const uint nStreams = 8, nNumbers = 2000;
+	std::vector<std::vector<double> > expected(nStreams), drawn(nStreams);
+	for(uint s = 0; s < nStreams; s++) {
+		PhiloxRandomizer randomizer;
+		randomizer.setStream(1, 2, 3, s + 1);
+		for(uint i = 0; i < nNumbers; i++)
+			expected[s].push_back(randomizer.getRandomDouble());
+	}
+
+	std::vector<std::thread> threads;
+	for(uint s = 0; s < nStreams; s++)
+		threads.push_back(std::thread([s, &drawn]() {
+			PhiloxRandomizer randomizer;
+			randomizer.setStream(1, 2, 3, s + 1);
+			for(uint i = 0; i < nNumbers; i++)
+				drawn[s].push_back(randomizer.getRandomDouble());
+		}));
+	for(uint s = 0; s < nStreams; s++)
+		threads[s].join();
+
+	for(uint s = 0; s < nStreams; s++)
+		CHECK(drawn[s] == expected[s]);
+}
+
+// numbers are in range
+void checkRanges()
+{
+	PhiloxRandomizer randomizer;
+	randomizer.setStream(5, 0, 1, 1);
+	for(uint i = 0; i < 10000; i++) {
+		double x = randomizer.getRandomDouble();
+		CHECK(x >= 0 && x < 1);
+		int k = randomizer.getRandomInteger(7);
+		CHECK(k >= 0 && k < 7);
+		k = randomizer.getRandomInteger(-3, 3);
+		CHECK(k >= -3 && k <= 3);
+	}
+}
+
+int main()
+{
+	checkKnownAnswers();
+	checkReplay();
+	checkDistinctStreams();
+	checkFillWords();
+	checkThreads();
+	checkRanges();
+	return CHECK_RESULT();
+}
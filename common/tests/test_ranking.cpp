@@ -0,0 +1,90 @@
+// FitnessRanking: rankings agree with sorting by isBetterThan, for the index sort and the radix sort
+#include <ecf/ECF.h>
+#include "../FitnessRanking.h"
+#include "Check.h"
+#include <algorithm>
+#include <cmath>
+
+bool better(IndividualP a, IndividualP b)
+{	return a->fitness->isBetterThan(b->fitness);	}
+
+std::vector<IndividualP> population(uint size, bool maximize, uint seed)
+{
+	std::vector<IndividualP> individuals;
+	uint64_t state = seed;
+	for(uint i = 0; i < size; i++) {
+		state = state * 6364136223846793005ull + 1442695040888963407ull;
+		// negative, positive, zero and repeated values, over many orders of magnitude
+		double value = ((int) (state >> 40) % 2001 - 1000) * std::pow(10., (double) ((state >> 20) % 13) - 6);
+		if(i % 17 == 0)
+			value = 0;
+		IndividualP individual (new Individual);
+		individual->fitness = maximize ? (FitnessP) new FitnessMax : (FitnessP) new FitnessMin;
+		individual->fitness->setValue(value);
+		individuals.push_back(individual);
+	}
+	return individuals;
+}
+
+// fitness values in ranking order (ties may come in any order, their values can't)
+std::vector<double> values(const std::vector<IndividualP> &individuals, const std::vector<uint> &order)
+{
+	std::vector<double> result;
+	for(uint i = 0; i < order.size(); i++)
+		result.push_back(individuals[order[i]]->fitness->getValue());
+	return result;
+}
+
+void checkRanking(uint size, bool maximize)
+{
+	std::vector<IndividualP> individuals = population(size, maximize, size + maximize);
+	std::vector<IndividualP> sorted = individuals;
+	std::stable_sort(sorted.begin(), sorted.end(), better);
+	std::vector<double> expected;
+	for(uint i = 0; i < size; i++)
+		expected.push_back(sorted[i]->fitness->getValue());
+
+	FitnessRanking ranking;
+	ranking.load(individuals);
+	CHECK(ranking.size() == size);
+
+	// every index once, best first
+	std::vector<uint> order = ranking.rank();
+	std::vector<uint> indices = order;
+	std::sort(indices.begin(), indices.end());
+	for(uint i = 0; i < size; i++)
+		CHECK(indices[i] == i);
+	CHECK(values(individuals, order) == expected);
+	CHECK(individuals[ranking.best()]->fitness->getValue() == expected[0]);
+
+	uint k = size / 3 + 1;
+	order = ranking.rankBest(k);
+	CHECK(order.size() == k);
+	CHECK(values(individuals, order) == std::vector<double>(expected.begin(), expected.begin() + k));
+
+	order = ranking.selectBest(k);
+	CHECK(order.size() == k);
+	std::vector<double> selected = values(individuals, order);
+	std::sort(selected.begin(), selected.end());
+	std::vector<double> best(expected.begin(), expected.begin() + k);
+	std::sort(best.begin(), best.end());
+	CHECK(selected == best);
+
+	// the fitness vector overload ranks the first size fitness objects
+	std::vector<FitnessP> fitness;
+	for(uint i = 0; i < size; i++)
+		fitness.push_back(individuals[i]->fitness);
+	fitness.push_back(fitness[0]);
+	ranking.load(fitness, size);
+	CHECK(values(individuals, ranking.rank()) == expected);
+}
+
+int main()
+{
+	const uint sizes[] = { 1, 2, 10, FitnessRanking::RADIX_THRESHOLD - 1, FitnessRanking::RADIX_THRESHOLD, 3000 };
+	for(uint i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		checkRanking(sizes[i], false);
+		checkRanking(sizes[i], true);
+	}
+	return CHECK_RESULT();
+}